@@ -0,0 +1,176 @@
+#include "Database.h"
+#include "Logger.h"
+#include "Options.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <Tools/RNG.hpp>
+#include <vector>
+
+/*
+* Reproducible benchmark of the output database: insert rate of saved
+* particles, and the time taken by the reads postprocess makes. These are
+* the scan of particles by id range (all of them on a first run, and the
+* newest tenth on a rerun) and the lookup of params by id for each
+* posterior sample.
+*
+* Usage: ./database_benchmark [num_rows ...]      (default 1000000)
+*/
+
+namespace DNest5
+{
+
+class DatabaseBenchmark
+{
+    private:
+        static constexpr const char* filename = "output/benchmark.db";
+        static constexpr int num_levels = 100;
+        static constexpr int rows_per_transaction = 1000;
+        static constexpr int num_lookups = 10000;
+
+        static void clear();
+        static double seconds_since(std::chrono::steady_clock::time_point t);
+
+        // The scan in postprocess's scan_particles(). Returns rows read.
+        static long long scan(sqlite::database& db, long long first_id,
+                              long long last_id);
+
+    public:
+        static void run(long long num_rows);
+};
+
+void DatabaseBenchmark::clear()
+{
+    for(std::string suffix: {"", "-wal", "-shm"})
+        std::remove((std::string(filename) + suffix).c_str());
+}
+
+double DatabaseBenchmark::seconds_since(std::chrono::steady_clock::time_point t)
+{
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(now - t).count();
+}
+
+long long DatabaseBenchmark::scan(sqlite::database& db, long long first_id,
+                                  long long last_id)
+{
+    long long count = 0;
+    db << "SELECT id, logl, tb, params IS NOT NULL FROM particles\
+           WHERE id > ? AND id <= ?;"
+       << first_id << last_id >> [&](long long, double, double, bool)
+                                   { ++count; };
+    return count;
+}
+
+void DatabaseBenchmark::run(long long num_rows)
+{
+    clear();
+    Database database(filename);
+    auto& db = database.db;
+
+    // Same seed every time
+    Tools::RNG rng;
+    rng.set_seed(0);
+
+    // A fake sampler and evenly spaced levels
+    db << "BEGIN;";
+    db << "INSERT INTO samplers VALUES (1, 5, 5, 10000, 1000, 0.1, NULL,\
+                                       10.0, 100.0, ?, 0);" << num_rows;
+    for(int i=0; i<num_levels; ++i)
+    {
+        db << "INSERT INTO levels (id, logx, logl, tb) VALUES (?, ?, ?, ?);"
+           << i << -double(i) << double(i) << 0.5;
+    }
+    db << "COMMIT;";
+
+    // Insert particles the way Sampler::save_particle does, but with many
+    // rows per transaction so that large sizes finish in reasonable time.
+    // Remember the ids of the full ones, to look up later.
+    std::vector<long long> full_ids;
+    auto start = std::chrono::steady_clock::now();
+    auto ps = db << "INSERT INTO particles (sampler, level, params, logl, tb)\
+                     VALUES (?, ?, ?, ?, ?);";
+    db << "BEGIN;";
+    for(long long i=0; i<num_rows; ++i)
+    {
+        double logl = num_levels*rng.rand();
+        int level = int(logl);
+        if(rng.rand() <= 0.1)
+        {
+            std::stringstream ss;
+            ss << std::setprecision(Options::stdout_precision);
+            ss << rng.randn() << ',' << rng.randn() << ',' << rng.randn();
+            ps << 1 << level << ss.str() << logl << rng.rand();
+            full_ids.push_back(i + 1);
+        }
+        else
+            ps << 1 << level << nullptr << logl << rng.rand();
+        ps++;
+
+        if((i+1) % rows_per_transaction == 0)
+        {
+            db << "COMMIT;";
+            db << "BEGIN;";
+        }
+    }
+    db << "COMMIT;";
+    double insert_time = seconds_since(start);
+
+    // Reads, on a connection set up the way postprocess sets up its own
+    sqlite::database reader(filename);
+    Database::reader_pragmas(reader);
+
+    start = std::chrono::steady_clock::now();
+    long long count = scan(reader, 0, num_rows);
+    double scan_time = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    scan(reader, num_rows - num_rows/10, num_rows);
+    double rescan_time = seconds_since(start);
+
+    // Params of random full particles, as for posterior.csv
+    start = std::chrono::steady_clock::now();
+    int lookups = 0;
+    for(int i=0; i<num_lookups && !full_ids.empty(); ++i)
+    {
+        std::vector<char> params;
+        reader << "SELECT params FROM particles WHERE id = ?;"
+               << full_ids[rng.rand_int(full_ids.size())] >> params;
+        ++lookups;
+    }
+    double lookup_time = seconds_since(start);
+
+    std::cout << "- num_rows: " << num_rows << '\n';
+    std::cout << "  inserts_per_second: " << num_rows/insert_time << '\n';
+    std::cout << "  id_range_scan_seconds: " << scan_time << '\n';
+    std::cout << "  rows_scanned: " << count << '\n';
+    std::cout << "  rescan_newest_tenth_seconds: " << rescan_time << '\n';
+    std::cout << "  params_lookups_per_second: " << lookups/lookup_time;
+    std::cout << '\n' << std::endl;
+
+    clear();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // Only the results on stdout
+    DNest5::Logger::get().configure("warning", "text", 0.0);
+
+    std::vector<long long> sizes;
+    for(int i=1; i<argc; ++i)
+        sizes.push_back(std::stoll(argv[i]));
+    if(sizes.size() == 0)
+        sizes.push_back(1000000);
+
+    for(long long num_rows: sizes)
+        DNest5::DatabaseBenchmark::run(num_rows);
+
+    return 0;
+}
+
@@ -0,0 +1,186 @@
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <Tools/RNG.hpp>
+#include <vector>
+
+/*
+* Microbenchmark of include/Kernels.hpp against the scalar loops the
+* examples used to contain, on random data of each given size.
+*
+* Usage: ./kernels_benchmark [size ...]      (default 32 1024 65536)
+*/
+
+namespace DNest5
+{
+
+class KernelsBenchmark
+{
+    private:
+        // Roughly this many elements are processed per timing
+        static constexpr double work = 2E8;
+
+        // Nanoseconds per call of f, and the sum of its results so that
+        // nothing is optimised away
+        template<typename F>
+        static double time(F&& f, int reps, double& result);
+
+        static void report(const std::string& name, int n,
+                           double scalar, double kernel,
+                           double scalar_result, double kernel_result);
+
+    public:
+        static void run(int n);
+};
+
+template<typename F>
+double KernelsBenchmark::time(F&& f, int reps, double& result)
+{
+    result = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<reps; ++i)
+        result += f();
+    auto end = std::chrono::steady_clock::now();
+    result /= reps;
+    return 1E9*std::chrono::duration<double>(end - start).count()/reps;
+}
+
+void KernelsBenchmark::report(const std::string& name, int n,
+                              double scalar, double kernel,
+                              double scalar_result, double kernel_result)
+{
+    std::cout << "- kernel: " << name << '\n';
+    std::cout << "  size: " << n << '\n';
+    std::cout << "  scalar_ns: " << scalar << '\n';
+    std::cout << "  kernel_ns: " << kernel << '\n';
+    std::cout << "  speedup: " << scalar/kernel << '\n';
+    std::cout << "  relative_difference: "
+              << std::abs(kernel_result - scalar_result)/std::abs(scalar_result)
+              << '\n' << std::endl;
+}
+
+void KernelsBenchmark::run(int n)
+{
+    Tools::RNG rng;
+    rng.set_seed(0);
+    std::vector<double> xs(n), ys(n);
+    for(int i=0; i<n; ++i)
+    {
+        xs[i] = rng.randn();
+        ys[i] = 3.0*xs[i] + 1.0 + rng.randn();
+    }
+    int reps = std::max(int(work/n), 1);
+    double r1, r2;
+
+    // Wiggle a parameter (or xs[0]) so the calls are not hoisted out of
+    // the loops. Each timing starts from the same state.
+    double mu = 0.0, x0 = xs[0];
+    auto wiggle = [&]() { mu = (mu == 0.0) ? 1E-12 : 0.0; return mu; };
+    auto restore = [&]() { mu = 0.0; xs[0] = x0; };
+
+    restore();
+    double scalar = time([&]()
+    {
+        double m = wiggle(), logl = 0.0;
+        for(int i=0; i<n; ++i)
+            logl += -0.5*log(2.0*M_PI) - 0.5*pow(xs[i] - m, 2);
+        return logl;
+    }, reps, r1);
+    restore();
+    double kernel = time([&]()
+    {
+        return Kernels::gaussian_logpdf_sum(xs, wiggle(), 1.0);
+    }, reps, r2);
+    report("gaussian_logpdf_sum", n, scalar, kernel, r1, r2);
+
+    restore();
+    scalar = time([&]()
+    {
+        double m = wiggle(), logl = 0.0;
+        for(int i=0; i<n; ++i)
+            logl += pow(ys[i] - (3.0*xs[i] + 1.0 + m), 2);
+        return logl;
+    }, reps, r1);
+    restore();
+    kernel = time([&]()
+    {
+        return Kernels::sum_squared_residuals(xs, ys, 3.0, 1.0 + wiggle());
+    }, reps, r2);
+    report("sum_squared_residuals", n, scalar, kernel, r1, r2);
+
+    double nu = 3.0;
+    restore();
+    scalar = time([&]()
+    {
+        double m = wiggle(), logl = 0.0;
+        double c = lgamma(0.5*(nu + 1.0)) - lgamma(0.5*nu) - 0.5*log(M_PI*nu);
+        for(int i=0; i<n; ++i)
+            logl += c - 0.5*(nu + 1.0)*log(1.0 + pow(xs[i] - m, 2)/nu);
+        return logl;
+    }, reps, r1);
+    restore();
+    kernel = time([&]()
+    {
+        return Kernels::student_t_logpdf_sum(xs, wiggle(), 1.0, nu);
+    }, reps, r2);
+    report("student_t_logpdf_sum", n, scalar, kernel, r1, r2);
+
+    restore();
+    scalar = time([&]()
+    {
+        xs[0] += wiggle();
+        double max = *std::max_element(xs.begin(), xs.end());
+        double s = 0.0;
+        for(int i=0; i<n; ++i)
+            s += exp(xs[i] - max);
+        return max + log(s);
+    }, reps, r1);
+    restore();
+    kernel = time([&]()
+    {
+        xs[0] += wiggle();
+        return Kernels::logsumexp(xs);
+    }, reps, r2);
+    report("logsumexp", n, scalar, kernel, r1, r2);
+
+    restore();
+    scalar = time([&]()
+    {
+        double logl = 0.0;
+        xs[0] += wiggle();
+        for(int i=0; i<n-1; ++i)
+        {
+            logl -= 100*pow(xs[i+1] - xs[i]*xs[i], 2);
+            logl -= pow(1.0 - xs[i], 2);
+        }
+        return 2*logl;
+    }, reps, r1);
+    restore();
+    kernel = time([&]()
+    {
+        xs[0] += wiggle();
+        return -2.0*Kernels::rosenbrock_sum(xs);
+    }, reps, r2);
+    report("rosenbrock_sum", n, scalar, kernel, r1, r2);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    for(int i=1; i<argc; ++i)
+        sizes.push_back(std::stoi(argv[i]));
+    if(sizes.size() == 0)
+        sizes = {32, 1024, 65536};
+
+    for(int n: sizes)
+        DNest5::KernelsBenchmark::run(n);
+
+    return 0;
+}
+
@@ -0,0 +1,189 @@
+#include "Examples/ABC.hpp"
+#include "Examples/Rosenbrock.hpp"
+#include "Examples/SpikeSlab.hpp"
+#include "Examples/StraightLine.hpp"
+#include "Misc.h"
+#include "Options.h"
+#include "Sampler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+* End-to-end benchmark of Sampler<T> on the example models, with fixed seeds
+* and the same amount of work (max_num_saves*save_interval MCMC steps) for
+* 1, 2, 4, ... up to max_threads threads. Reports steps and likelihood calls
+* per second, when the last level was created, and parallel efficiency
+* relative to one thread, as JSON on stdout, e.g. for diffing between
+* releases. The sampler's own messages are suppressed. Run it from the
+* repository root, as the models load Examples/ data, and note that it
+* clears the output directory.
+*
+* Usage: ./sampler_benchmark [max_threads [max_num_saves]]
+*                           (default: hardware threads, 256)
+*/
+
+namespace DNest5
+{
+
+class SamplerBenchmark
+{
+    private:
+        // Divisible by every power-of-two thread count up to 256
+        static constexpr int num_particles = 256;
+        static constexpr int save_interval = 1024;
+        static constexpr int rng_seed = 1234;
+
+        int max_threads, max_num_saves;
+        std::vector<std::string> results;
+
+        template<typename T>
+        void run(const std::string& model, int num_threads,
+                 double& steps_per_second_one_thread);
+
+        // Options from YAML text, by way of a temporary file, so that each
+        // option is set by name
+        static Options options_from_yaml(const std::string& yaml);
+
+    public:
+        SamplerBenchmark(int _max_threads, int _max_num_saves);
+
+        template<typename T>
+        void run(const std::string& model);
+
+        std::string json() const;
+};
+
+SamplerBenchmark::SamplerBenchmark(int _max_threads, int _max_num_saves)
+:max_threads(_max_threads)
+,max_num_saves(_max_num_saves)
+{
+
+}
+
+template<typename T>
+void SamplerBenchmark::run(const std::string& model)
+{
+    std::cerr << "Benchmarking " << model << "..." << std::flush;
+    double one_thread = 0.0;
+    for(int num_threads=1; num_threads<=max_threads; num_threads*=2)
+        run<T>(model, num_threads, one_thread);
+    std::cerr << "done." << std::endl;
+}
+
+template<typename T>
+void SamplerBenchmark::run(const std::string& model, int num_threads,
+                           double& steps_per_second_one_thread)
+{
+    // No helper threads, so that num_threads is all there is, no status
+    // file, and a silent sampler
+    std::stringstream yaml;
+    yaml << "num_particles: " << num_particles << '\n';
+    yaml << "num_threads: " << num_threads << '\n';
+    yaml << "new_level_interval: 10000\n";
+    yaml << "save_interval: " << save_interval << '\n';
+    yaml << "thin: 0.1\n";
+    yaml << "max_num_levels: \"auto\"\n";
+    yaml << "lambda: 10.0\n";
+    yaml << "beta: 100.0\n";
+    yaml << "max_num_saves: " << max_num_saves << '\n';
+    yaml << "rng_seed: " << rng_seed << '\n';
+    yaml << "helper_threads: 0\n";
+    yaml << "status_interval: \"none\"\n";
+    yaml << "log_level: \"quiet\"\n";
+    Options options = options_from_yaml(yaml.str());
+    clear_output_dir();
+    auto start = std::chrono::steady_clock::now();
+    Sampler<T> sampler(options);
+    sampler.run();
+    double seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+
+    double steps = sampler.get_work();
+    double calls = sampler.get_likelihood_calls();
+    if(num_threads == 1)
+        steps_per_second_one_thread = steps/seconds;
+
+    std::stringstream ss;
+    ss << std::setprecision(6);
+    ss << "    {\"model\": \"" << model << "\", ";
+    ss << "\"threads\": " << num_threads << ", ";
+    ss << "\"seconds\": " << seconds << ", ";
+    ss << "\"steps\": " << sampler.get_work() << ", ";
+    ss << "\"steps_per_second\": " << steps/seconds << ", ";
+    ss << "\"likelihood_calls\": " << sampler.get_likelihood_calls() << ", ";
+    ss << "\"likelihood_calls_per_second\": " << calls/seconds << ", ";
+    ss << "\"levels\": " << sampler.get_num_levels() << ", ";
+    ss << "\"level_creation_seconds\": " << sampler.get_level_seconds() << ", ";
+    ss << "\"parallel_efficiency\": ";
+    ss << steps/seconds/(num_threads*steps_per_second_one_thread) << "}";
+    results.push_back(ss.str());
+}
+
+Options SamplerBenchmark::options_from_yaml(const std::string& yaml)
+{
+    auto filename = std::filesystem::temp_directory_path()
+                        / ("dnest5_options_" + std::to_string(getpid())
+                                                                + ".yaml");
+    {
+        std::fstream fout(filename, std::ios::out);
+        fout << yaml;
+    }
+    Options options(filename.c_str());
+    std::filesystem::remove(filename);
+    return options;
+}
+
+std::string SamplerBenchmark::json() const
+{
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "  \"benchmark\": \"sampler\",\n";
+    ss << "  \"hardware_threads\": " << std::thread::hardware_concurrency();
+    ss << ",\n";
+    ss << "  \"num_particles\": " << num_particles << ",\n";
+    ss << "  \"save_interval\": " << save_interval << ",\n";
+    ss << "  \"max_num_saves\": " << max_num_saves << ",\n";
+    ss << "  \"rng_seed\": " << rng_seed << ",\n";
+    ss << "  \"results\":\n  [\n";
+    for(std::size_t i=0; i<results.size(); ++i)
+        ss << results[i] << ((i + 1 < results.size())?(",\n"):("\n"));
+    ss << "  ]\n}";
+    return ss.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int max_threads = std::max(1U, std::thread::hardware_concurrency());
+    int max_num_saves = 256;
+    if(argc >= 2)
+        max_threads = std::atoi(argv[1]);
+    if(argc >= 3)
+        max_num_saves = std::atoi(argv[2]);
+
+    // Every thread count must divide the particles and saves
+    max_threads = std::clamp(max_threads, 1, 256);
+    max_num_saves = std::max(256, max_num_saves/256*256);
+
+    DNest5::SamplerBenchmark benchmark(max_threads, max_num_saves);
+    benchmark.run<DNest5::StraightLine>("StraightLine");
+    benchmark.run<DNest5::SpikeSlab>("SpikeSlab");
+    benchmark.run<DNest5::Rosenbrock>("Rosenbrock");
+    benchmark.run<DNest5::ABC>("ABC");
+    std::cout << benchmark.json() << std::endl;
+
+    return 0;
+}
+
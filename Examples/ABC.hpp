@@ -3,8 +3,11 @@
 
 #include <algorithm>
 #include <cstring>
+#include "Dataset.h"
+#include "Logger.h"
 #include "ParameterNames.h"
-#include <fstream>
+#include "SimulatorModel.hpp"
+#include <span>
 #include <sstream>
 #include <string>
 #include <Tools/Misc.hpp>
@@ -16,7 +19,8 @@ namespace DNest5
 
 using Tools::RNG, Tools::wrap;
 
-class ABC
+// Summaries are the minimum and maximum
+class ABC : public SimulatorModel<ABC, 2>
 {
     private:
         double mu;
@@ -27,7 +31,6 @@ class ABC
 
         inline ABC(RNG& rng);
         inline double perturb(RNG& rng);
-        inline double log_likelihood() const;
         inline std::vector<char> to_blob() const;
         inline void from_blob(const std::vector<char>& vec);
         inline std::string to_string() const;
@@ -36,8 +39,9 @@ class ABC
     /* Static things */
 	private:
 
-        // The data
-        static std::vector<double> data_xs;
+        // The data, and its only column
+        static Dataset data;
+        static std::span<const double> data_xs;
 
     public:
 
@@ -45,23 +49,28 @@ class ABC
         static ParameterNames parameter_names;
 
         // Data loader
-        inline static void load_data(const char* filename);
+        inline static void load_data(const char* filename="Examples/abc_data.txt");
+
+        // What SimulatorModel needs
+        std::size_t simulation_size() const { return ns.size(); }
+        inline void simulate(std::span<double> out) const;
+        inline static Summaries summaries(std::span<const double> data);
 };
 
 /* IMPLEMENTATIONS FOLLOW */
 
-std::vector<double> ABC::data_xs;
+Dataset ABC::data;
+std::span<const double> ABC::data_xs;
 ParameterNames ABC::parameter_names(0);
 
 inline void ABC::load_data(const char* filename)
 {
-    data_xs.clear();
-    std::fstream fin(filename, std::ios::in);
-    double x;
-    while(fin >> x)
-        data_xs.push_back(x);
-    fin.close();
-    std::cout << "Loaded " << data_xs.size() << " data points." << std::endl;
+    data = Dataset(filename);
+    data_xs = data.column(0);
+    set_observed(data_xs);
+    log_event(LogLevel::info, "data_loaded",
+              "Loaded " + std::to_string(data_xs.size()) + " data points.",
+              {{"num_points", data_xs.size()}});
 
     // Set parameter names
     std::vector<std::string> names = {"mu", "sigma"};
@@ -76,9 +85,6 @@ inline void ABC::load_data(const char* filename)
 
 inline ABC::ABC(RNG& rng)
 {
-    if(data_xs.size() == 0)
-        load_data("Examples/abc_data.txt");
-
     mu = -10.0 + 20.0*rng.rand();
     sigma = exp(-10.0 + 20.0*rng.rand());
 
@@ -118,22 +124,16 @@ inline double ABC::perturb(RNG& rng)
     return logh;
 }
 
-inline double ABC::log_likelihood() const
+inline void ABC::simulate(std::span<double> out) const
 {
-    double logl = 0.0;
-
-    // Compute fake dataset
-    std::vector<double> xs(ns.size());
     for(size_t i=0; i<ns.size(); ++i)
-        xs[i] = mu + sigma*ns[i];
-
-    // Real min and max
-    double xmin = *min_element(data_xs.begin(), data_xs.end());
-    double xmax = *max_element(data_xs.begin(), data_xs.end());
-    logl += -std::abs(xmin - *min_element(xs.begin(), xs.end()));
-    logl += -std::abs(xmax - *max_element(xs.begin(), xs.end()));
+        out[i] = mu + sigma*ns[i];
+}
 
-    return logl;
+inline ABC::Summaries ABC::summaries(std::span<const double> data)
+{
+    auto [min, max] = std::minmax_element(data.begin(), data.end());
+    return {*min, *max};
 }
 
 inline void ABC::from_blob(const std::vector<char>& vec)
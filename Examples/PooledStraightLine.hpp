@@ -0,0 +1,47 @@
+#ifndef DNest5_PooledStraightLine_hpp
+#define DNest5_PooledStraightLine_hpp
+
+#include "StraightLine.hpp"
+#include "ThreadPool.h"
+#include <vector>
+
+namespace DNest5
+{
+
+/*
+* StraightLine with its sum of squared residuals split over the sampler's
+* ThreadPool, as a model with a long loop over its data would do. The
+* results are the same as StraightLine's, up to rounding.
+*/
+class PooledStraightLine : public StraightLine
+{
+    public:
+        using StraightLine::StraightLine;
+        inline double log_likelihood(ThreadPool& pool) const;
+};
+
+/* Implementations follow */
+
+inline double PooledStraightLine::log_likelihood(ThreadPool& pool) const
+{
+    // One partial sum per block, added up in order afterwards
+    std::vector<double> partial_ssrs(pool.size(), 0.0);
+    pool.parallel_for(data_xs.size(),
+                      [&](int block, long long begin, long long end)
+    {
+        partial_ssrs[block] = Kernels::sum_squared_residuals(
+                            data_xs.subspan(begin, end - begin),
+                            data_ys.subspan(begin, end - begin),
+                            param<"m">(), param<"b">());
+    });
+
+    double ssr = 0.0;
+    for(double partial_ssr: partial_ssrs)
+        ssr += partial_ssr;
+    double var = pow(param<"sigma">(), 2);
+    return -0.5*data_xs.size()*log(2.0*M_PI*var) - 0.5*ssr/var;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef DNest5_Pulses_hpp
+#define DNest5_Pulses_hpp
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include "Dataset.h"
+#include "Kernels.hpp"
+#include "ParameterNames.h"
+#include "RJObject.hpp"
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <Tools/Misc.hpp>
+#include <iostream>
+#include <Tools/RNG.hpp>
+#include <vector>
+
+namespace DNest5
+{
+
+using Tools::RNG, Tools::wrap;
+
+/*
+    Conditional prior for Pulses. Positions are uniform over the time range
+    of the data, amplitudes are exponential with mean mu (the
+    hyperparameter), and widths are log-uniform.
+*/
+class PulsePrior
+{
+    private:
+        double mu;
+
+    public:
+        // Set by Pulses::load_data()
+        static double t_min, t_max;
+
+        static constexpr std::array<std::string_view, 1> names{"mu"};
+        static constexpr std::array<std::string_view, 3> component_names
+                                        {"position", "amplitude", "width"};
+
+        inline PulsePrior(RNG& rng);
+        inline double perturb(RNG& rng);
+        inline std::array<double, 3>
+                from_uniform(const std::array<double, 3>& us) const;
+        inline std::string to_string() const;
+};
+
+/*
+    A signal made of up to 300 Gaussian pulses, plus noise. The data
+    (Examples/pulses.txt, 1000 points with times in increasing order) was
+    generated from 100 pulses and noise with sigma = 0.1.
+
+    The model signal is kept up to date incrementally: each proposal that
+    adds, removes or moves a few pulses only touches the data points near
+    them. It is recomputed in full after hyperparameter moves and
+    periodically, so rounding errors cannot build up. The signal has room
+    for a fixed number of points, like RJObject's pool, so copying a Pulses
+    (for every proposal) doesn't allocate.
+*/
+class Pulses
+{
+    private:
+        RJObject<PulsePrior, 3, 300> pulses;
+        double sigma;
+
+        // Data points there is room for
+        static constexpr int max_num_points = 1000;
+
+        // The model signal at each data point
+        std::array<double, max_num_points> signal;
+        int updates_since_full;
+
+        // Add sign times one pulse to the signal
+        inline void add_pulse(const std::array<double, 3>& pulse, double sign);
+        inline void compute_signal();
+
+        // The data, and its columns
+        static Dataset data;
+        static std::span<const double> data_ts, data_ys;
+
+        // Incremental updates between full recomputations
+        static constexpr int full_update_interval = 1000;
+
+        static ParameterNames make_parameter_names();
+
+    public:
+
+        // The parameter names
+        static const ParameterNames parameter_names;
+
+        // Data loader
+        inline static void load_data(const char* filename="Examples/pulses.txt");
+
+        inline Pulses(RNG& rng);
+        inline double perturb(RNG& rng);
+        inline double log_likelihood() const;
+        inline std::string to_string() const;
+
+        // Largest difference between the signal and a full recomputation
+        inline double signal_error() const;
+};
+
+/* IMPLEMENTATIONS FOLLOW */
+
+double PulsePrior::t_min = 0.0;
+double PulsePrior::t_max = 1.0;
+
+inline PulsePrior::PulsePrior(RNG& rng)
+{
+    mu = exp(log(1E-3) + log(1E6)*rng.rand());
+}
+
+inline double PulsePrior::perturb(RNG& rng)
+{
+    mu = log(mu);
+    mu += log(1E6)*rng.randh();
+    wrap(mu, log(1E-3), log(1E3));
+    mu = exp(mu);
+    return 0.0;
+}
+
+inline std::array<double, 3>
+PulsePrior::from_uniform(const std::array<double, 3>& us) const
+{
+    return {t_min + (t_max - t_min)*us[0],
+            -mu*log(1.0 - us[1]),
+            exp(log(0.03) + log(100.0)*us[2])};
+}
+
+inline std::string PulsePrior::to_string() const
+{
+    std::stringstream ss;
+    ss << std::setprecision(Options::stdout_precision) << mu;
+    return ss.str();
+}
+
+Dataset Pulses::data;
+std::span<const double> Pulses::data_ts;
+std::span<const double> Pulses::data_ys;
+
+ParameterNames Pulses::make_parameter_names()
+{
+    std::vector<std::string> names = {"sigma"};
+    for(auto& name: RJObject<PulsePrior, 3, 300>::names())
+        names.emplace_back(std::move(name));
+    return ParameterNames(names);
+}
+const ParameterNames Pulses::parameter_names = make_parameter_names();
+
+inline void Pulses::load_data(const char* filename)
+{
+    data = Dataset(filename);
+    data_ts = data.column(0);
+    data_ys = data.column(1);
+    if(data_ts.size() > max_num_points)
+    {
+        std::cerr << "Pulses has room for " << max_num_points << " points, ";
+        std::cerr << "but " << filename << " has " << data_ts.size() << ".";
+        std::cerr << std::endl;
+        exit(-1);
+    }
+    PulsePrior::t_min = data_ts.front();
+    PulsePrior::t_max = data_ts.back();
+}
+
+inline Pulses::Pulses(RNG& rng)
+:pulses(rng)
+,sigma(exp(-10.0 + 20.0*rng.rand()))
+{
+    compute_signal();
+}
+
+inline void Pulses::add_pulse(const std::array<double, 3>& pulse, double sign)
+{
+    const auto& [position, amplitude, width] = pulse;
+
+    // Only the points within five widths of the centre
+    auto begin = std::lower_bound(data_ts.begin(), data_ts.end(),
+                                  position - 5.0*width);
+    auto end = std::upper_bound(begin, data_ts.end(), position + 5.0*width);
+    double tau = 1.0/(width*width);
+    for(auto it=begin; it!=end; ++it)
+    {
+        double d = *it - position;
+        signal[it - data_ts.begin()] += sign*amplitude*exp(-0.5*tau*d*d);
+    }
+}
+
+inline void Pulses::compute_signal()
+{
+    std::fill_n(signal.begin(), data_ts.size(), 0.0);
+    for(const auto& pulse: pulses.components())
+        add_pulse(pulse, 1.0);
+    updates_since_full = 0;
+}
+
+inline double Pulses::perturb(RNG& rng)
+{
+    double logh = 0.0;
+
+    if(rng.rand() <= 0.75)
+    {
+        logh += pulses.perturb(rng);
+        if(logh == Tools::minus_infinity)
+            return logh;
+
+        if(pulses.everything_changed() ||
+           ++updates_since_full >= full_update_interval)
+            compute_signal();
+        else
+        {
+            for(const auto& pulse: pulses.get_removed())
+                add_pulse(pulse, -1.0);
+            for(const auto& pulse: pulses.get_added())
+                add_pulse(pulse, 1.0);
+        }
+    }
+    else
+    {
+        sigma = log(sigma);
+        sigma += 20.0*rng.randh();
+        wrap(sigma, -10.0, 10.0);
+        sigma = exp(sigma);
+    }
+
+    return logh;
+}
+
+inline double Pulses::log_likelihood() const
+{
+    double var = sigma*sigma;
+    double ssd = Kernels::sum_squared_differences(data_ys,
+                            std::span<const double>(signal.data(),
+                                                    data_ys.size()));
+    return -0.5*data_ys.size()*log(2.0*M_PI*var) - 0.5*ssd/var;
+}
+
+inline std::string Pulses::to_string() const
+{
+    std::stringstream ss;
+    ss << std::setprecision(Options::stdout_precision);
+    ss << sigma << ',' << pulses.to_string();
+    return ss.str();
+}
+
+inline double Pulses::signal_error() const
+{
+    Pulses full = *this;
+    full.compute_signal();
+    double error = 0.0;
+    for(std::size_t i=0; i<data_ts.size(); ++i)
+        error = std::max(error, std::abs(signal[i] - full.signal[i]));
+    return error;
+}
+
+} // namespace
+
+#endif
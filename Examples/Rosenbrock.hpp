@@ -1,6 +1,10 @@
 #ifndef DNest5_Rosenbrock_hpp
 #define DNest5_Rosenbrock_hpp
 
+#include <algorithm>
+#include "Kernels.hpp"
+#include <optional>
+#include <span>
 #include "UniformModel.hpp"
 
 namespace DNest5
@@ -10,11 +14,17 @@ class Rosenbrock : public UniformModel<50, Rosenbrock>
 {
     private:
 
+        // Terms added between checks against the threshold
+        static constexpr std::size_t chunk_size = 8;
+
     public:
 
         inline Rosenbrock(RNG& rng);
         inline void us_to_params();
         inline double log_likelihood() const;
+
+        // Stops once the log likelihood is below the threshold
+        inline std::optional<double> log_likelihood(double threshold) const;
 };
 
 /* Implementations follow */
@@ -33,16 +43,21 @@ inline void Rosenbrock::us_to_params()
 
 inline double Rosenbrock::log_likelihood() const
 {
-    double logl = 0.0;
+    return *log_likelihood(Tools::minus_infinity);
+}
 
-    for(size_t i=0; i<(xs.size()-1); ++i)
+inline std::optional<double> Rosenbrock::log_likelihood(double threshold) const
+{
+    // Every term is non-positive, so the partial sums only go down
+    std::span<const double> x(xs);
+    double logl = 0.0;
+    for(std::size_t i=0; i+1<x.size(); i+=chunk_size)
     {
-        logl -= 100*pow(xs[i+1] - xs[i]*xs[i], 2);
-        logl -= pow(1.0 - xs[i], 2);
+        std::size_t terms = std::min(chunk_size, x.size() - 1 - i);
+        logl -= 2.0*Kernels::rosenbrock_sum(x.subspan(i, terms + 1));
+        if(logl < threshold)
+            return std::nullopt;
     }
-
-    logl *= 2;
-
     return logl;
 }
 
@@ -1,7 +1,9 @@
 #ifndef DNest5_SpikeSlab_hpp
 #define DNest5_SpikeSlab_hpp
 
+#include "Kernels.hpp"
 #include "UniformModel.hpp"
+#include <array>
 
 namespace DNest5
 {
@@ -33,9 +35,6 @@ inline void SpikeSlab::us_to_params()
 
 inline double SpikeSlab::log_likelihood() const
 {
-    double logL1 = 0.0;
-    double logL2 = 0.0;
-
     static constexpr double u = 0.1;
     static constexpr double v = 0.01;
     static constexpr double shift = 0.031;
@@ -45,12 +44,11 @@ inline double SpikeSlab::log_likelihood() const
     static constexpr double tau2 = 1.0/(v*v);
     static constexpr double log_hundred = log(100.0);
 
-    for(double x: xs)
-    {
-        logL1 += C1 - 0.5*tau1*pow(x - 0.5, 2);
-        logL2 += C2 - 0.5*tau2*pow(x - 0.5 - shift, 2);
-    }
-    return logsumexp(std::vector<double>{logL1, log_hundred + logL2});
+    double logL1 = xs.size()*C1
+                    - 0.5*tau1*Kernels::sum_squared_deviations(xs, 0.5);
+    double logL2 = xs.size()*C2
+                    - 0.5*tau2*Kernels::sum_squared_deviations(xs, 0.5 + shift);
+    return Kernels::logsumexp(std::array{logL1, log_hundred + logL2});
 }
 
 
@@ -0,0 +1,140 @@
+#include "CommandLineOptions.h"
+#include "Misc.h"
+#include "Options.h"
+#include "Postprocessing.h"
+#include "Sampler.hpp"
+#include "UniformModel.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sqlite_modern_cpp/hdr/sqlite_modern_cpp.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+/*
+* Runs the sampler on a narrow Gaussian in the unit square, whose log
+* evidence is 0, with num_tries = 1 and with several tries per step. Each
+* run's log(Z) must be near 0 and the fractions of saved particles in each
+* level (after the levels are built) must agree between the runs.
+* Exits with 1 if they don't. Run it from the repository root, as it
+* clears the output directory.
+*/
+
+namespace DNest5
+{
+
+class Gaussian : public UniformModel<2, Gaussian>
+{
+    public:
+        static constexpr double sigma = 0.01;
+
+        Gaussian(RNG& rng) :UniformModel(rng) { us_to_params(); }
+        void us_to_params() { xs = us; }
+        double log_likelihood() const
+        {
+            double logl = 0.0;
+            for(double x: xs)
+                logl += -0.5*log(2*M_PI*sigma*sigma)
+                            - 0.5*pow((x - 0.5)/sigma, 2);
+            return logl;
+        }
+};
+
+// Options from YAML text, by way of a temporary file, so that each option
+// is set by name
+Options options_from_yaml(const std::string& yaml)
+{
+    auto filename = std::filesystem::temp_directory_path()
+                        / ("dnest5_options_" + std::to_string(getpid())
+                                                                + ".yaml");
+    {
+        std::fstream fout(filename, std::ios::out);
+        fout << yaml;
+    }
+    Options options(filename.c_str());
+    std::filesystem::remove(filename);
+    return options;
+}
+
+struct Run
+{
+    double logz;
+    std::vector<double> fractions;
+};
+
+Run run(int num_tries)
+{
+    constexpr int num_levels = 12;
+    constexpr int max_num_saves = 8000;
+
+    auto options = options_from_yaml(
+"num_particles: 5\n\
+num_threads: 1\n\
+new_level_interval: 2000\n\
+save_interval: 200\n\
+thin: 0.1\n\
+max_num_levels: " + std::to_string(num_levels) + "\n\
+lambda: 10.0\n\
+beta: 100.0\n\
+max_num_saves: " + std::to_string(max_num_saves) + "\n\
+rng_seed: 1234\n\
+num_tries: " + std::to_string(num_tries) + "\n\
+helper_threads: 0\n\
+status_interval: \"none\"\n\
+log_level: \"quiet\"\n");
+    clear_output_dir();
+    Sampler<Gaussian> sampler(options);
+    sampler.run();
+
+    // Level fractions over the second half of the saves
+    Run result{0.0, std::vector<double>(num_levels, 0.0)};
+    {
+        sqlite::database db("output/dnest5.db");
+        double total = 0.0;
+        db << "SELECT level, COUNT(*) FROM particles WHERE id > ? \
+               GROUP BY level;" << max_num_saves/2
+           >> [&](int level, double count)
+              {
+                  result.fractions[level] = count;
+                  total += count;
+              };
+        for(double& f: result.fractions)
+            f /= total;
+    }
+
+    char name[] = "postprocess";
+    char* argv[] = {name, nullptr};
+    postprocess<Gaussian>(CommandLineOptions(1, argv));
+    result.logz = YAML::LoadFile("output/results.yaml")["logz"].as<double>();
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    constexpr double logz_tolerance = 0.3;
+    constexpr double fraction_tolerance = 0.025;
+
+    auto one = DNest5::run(1);
+    auto many = DNest5::run(8);
+
+    bool ok = std::abs(one.logz) < logz_tolerance
+                && std::abs(many.logz) < logz_tolerance;
+    std::cerr << "log(Z): " << one.logz << " (1 try), ";
+    std::cerr << many.logz << " (8 tries)" << std::endl;
+
+    std::cerr << "Level fractions:";
+    for(std::size_t i=0; i<one.fractions.size(); ++i)
+    {
+        std::cerr << ' ' << one.fractions[i] << '/' << many.fractions[i];
+        ok = ok && std::abs(one.fractions[i] - many.fractions[i])
+                                                    < fraction_tolerance;
+    }
+    std::cerr << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
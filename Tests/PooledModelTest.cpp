@@ -0,0 +1,100 @@
+#include "CommandLineOptions.h"
+#include "Examples/PooledStraightLine.hpp"
+#include "Examples/StraightLine.hpp"
+#include "Misc.h"
+#include "Options.h"
+#include "Postprocessing.h"
+#include "Sampler.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+/*
+* Runs StraightLine and PooledStraightLine, which splits its likelihood
+* over the sampler's ThreadPool, with several sampler threads and helpers
+* and two tries per step, so that the pool's parallel_for is called from
+* many threads at once and from inside itself. Exits with 1 if the run
+* hangs or the two log(Z)s disagree. Run it from the repository root, as
+* the models load Examples/ data and it clears the output directory.
+*/
+
+namespace DNest5
+{
+
+// Options from YAML text, by way of a temporary file, so that each option
+// is set by name
+Options options_from_yaml(const std::string& yaml)
+{
+    auto filename = std::filesystem::temp_directory_path()
+                        / ("dnest5_options_" + std::to_string(getpid())
+                                                                + ".yaml");
+    {
+        std::fstream fout(filename, std::ios::out);
+        fout << yaml;
+    }
+    Options options(filename.c_str());
+    std::filesystem::remove(filename);
+    return options;
+}
+
+template<typename T>
+double logz()
+{
+    auto options = options_from_yaml(
+"num_particles: 8\n\
+num_threads: 4\n\
+new_level_interval: 2000\n\
+save_interval: 400\n\
+thin: 0.1\n\
+max_num_levels: 25\n\
+lambda: 10.0\n\
+beta: 100.0\n\
+max_num_saves: 2000\n\
+rng_seed: 1234\n\
+num_tries: 2\n\
+helper_threads: 3\n\
+status_interval: \"none\"\n\
+log_level: \"quiet\"\n");
+    clear_output_dir();
+    Sampler<T> sampler(options);
+    sampler.run();
+
+    char name[] = "postprocess";
+    char* argv[] = {name, nullptr};
+    postprocess<T>(CommandLineOptions(1, argv));
+    return YAML::LoadFile("output/results.yaml")["logz"].as<double>();
+}
+
+} // namespace
+
+int main()
+{
+    constexpr double timeout = 600.0;
+    constexpr double tolerance = 0.5;
+
+    // A deadlock would hang rather than fail, so give up after a while
+    std::thread([=]()
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(timeout));
+        std::cerr << "Timed out after " << timeout << " s. FAILED";
+        std::cerr << std::endl;
+        std::_Exit(1);
+    }).detach();
+
+    double plain = DNest5::logz<DNest5::StraightLine>();
+    double pooled = DNest5::logz<DNest5::PooledStraightLine>();
+
+    bool ok = std::abs(plain - pooled) < tolerance;
+    std::cerr << "log(Z): " << plain << " (StraightLine), " << pooled;
+    std::cerr << " (PooledStraightLine)" << (ok ? " ok" : " FAILED");
+    std::cerr << std::endl;
+    return ok ? 0 : 1;
+}
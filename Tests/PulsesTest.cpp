@@ -0,0 +1,102 @@
+#include "Examples/Pulses.hpp"
+#include "Misc.h"
+#include "Options.h"
+#include "Sampler.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <Tools/Misc.hpp>
+#include <Tools/RNG.hpp>
+#include <unistd.h>
+
+/*
+* Runs the Pulses example as a Metropolis chain on its posterior, checking
+* that the incrementally updated signal stays within 1e-12 of a full
+* recomputation, and then briefly in the sampler. Exits with 1 if the
+* signal drifts. Run it from the repository root, as Pulses loads
+* Examples/ data and the sampler clears the output directory.
+*/
+
+namespace DNest5
+{
+
+// Options from YAML text, by way of a temporary file, so that each option
+// is set by name
+Options options_from_yaml(const std::string& yaml)
+{
+    auto filename = std::filesystem::temp_directory_path()
+                        / ("dnest5_options_" + std::to_string(getpid())
+                                                                + ".yaml");
+    {
+        std::fstream fout(filename, std::ios::out);
+        fout << yaml;
+    }
+    Options options(filename.c_str());
+    std::filesystem::remove(filename);
+    return options;
+}
+
+bool signal_stays_close()
+{
+    constexpr int steps = 100000;
+    constexpr int check_interval = 7;
+    constexpr double tolerance = 1E-12;
+
+    Tools::RNG rng;
+    rng.set_seed(1);
+    Pulses pulses(rng);
+    double logl = pulses.log_likelihood();
+
+    double error = 0.0;
+    for(int i=0; i<steps; ++i)
+    {
+        auto proposal = pulses;
+        double logh = proposal.perturb(rng);
+        if(logh != Tools::minus_infinity)
+        {
+            double logl_prop = proposal.log_likelihood();
+            if(rng.rand() <= exp(logh + logl_prop - logl))
+            {
+                pulses = proposal;
+                logl = logl_prop;
+            }
+        }
+        if(i % check_interval == 0)
+            error = std::max(error, pulses.signal_error());
+    }
+
+    bool ok = error < tolerance;
+    std::cout << "Largest signal error: " << error;
+    std::cout << (ok ? " ok" : " FAILED") << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    DNest5::Pulses::load_data();
+    bool ok = DNest5::signal_stays_close();
+
+    auto options = DNest5::options_from_yaml(
+"num_particles: 4\n\
+num_threads: 2\n\
+new_level_interval: 2000\n\
+save_interval: 200\n\
+thin: 0.1\n\
+max_num_levels: \"auto\"\n\
+lambda: 10.0\n\
+beta: 100.0\n\
+max_num_saves: 100\n\
+rng_seed: 1234\n\
+status_interval: \"none\"\n\
+log_level: \"quiet\"\n");
+    DNest5::clear_output_dir();
+    DNest5::Sampler<DNest5::Pulses> sampler(options);
+    sampler.run();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "RJObject.hpp"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <Tools/Misc.hpp>
+#include <Tools/RNG.hpp>
+
+/*
+* Runs RJObject::perturb() as a Metropolis chain on the prior alone, the way
+* the sampler does (pre-rejecting with the Hastings factor), and checks that
+* the number of components stays uniform on 0, ..., max_num_components.
+* Exits with 1 if any frequency is off.
+*/
+
+namespace DNest5
+{
+
+// A conditional prior without hyperparameters
+class PlainPrior
+{
+    public:
+        static constexpr std::array<std::string_view, 0> names{};
+        static constexpr std::array<std::string_view, 1> component_names{"x"};
+
+        PlainPrior(Tools::RNG&) { }
+        double perturb(Tools::RNG&) { return 0.0; }
+        std::array<double, 1> from_uniform(const std::array<double, 1>& us) const
+        { return us; }
+        std::string to_string() const { return ""; }
+};
+
+// One with a Uniform(0, 1) hyperparameter
+class ScaledPrior
+{
+    private:
+        double scale;
+
+    public:
+        static constexpr std::array<std::string_view, 1> names{"scale"};
+        static constexpr std::array<std::string_view, 1> component_names{"x"};
+
+        ScaledPrior(Tools::RNG& rng) :scale(rng.rand()) { }
+        double perturb(Tools::RNG& rng)
+        {
+            scale += rng.randh();
+            Tools::wrap(scale);
+            return 0.0;
+        }
+        std::array<double, 1> from_uniform(const std::array<double, 1>& us) const
+        { return {scale*us[0]}; }
+        std::string to_string() const { return std::to_string(scale); }
+};
+
+template<typename P>
+bool prior_on_size_is_uniform(const std::string& name)
+{
+    constexpr int max_num_components = 4;
+    constexpr long long steps = 4000000;
+    constexpr double tolerance = 0.01;
+
+    Tools::RNG rng;
+    rng.set_seed(1);
+    RJObject<P, 1, max_num_components> object(rng);
+
+    std::array<double, max_num_components + 1> frequencies{};
+    for(long long i=0; i<steps; ++i)
+    {
+        auto proposal = object;
+        double logh = proposal.perturb(rng);
+        if(rng.rand() <= exp(logh))
+            object = proposal;
+        frequencies[object.size()] += 1.0/steps;
+    }
+
+    bool ok = true;
+    std::cout << name << ":";
+    for(double f: frequencies)
+    {
+        std::cout << ' ' << f;
+        ok = ok && std::abs(f - 1.0/(max_num_components + 1)) < tolerance;
+    }
+    std::cout << (ok ? " ok" : " FAILED") << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = DNest5::prior_on_size_is_uniform<DNest5::PlainPrior>("PlainPrior");
+    ok = DNest5::prior_on_size_is_uniform<DNest5::ScaledPrior>("ScaledPrior")
+            && ok;
+    return ok ? 0 : 1;
+}
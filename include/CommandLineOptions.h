@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 namespace DNest5
 {
@@ -17,9 +18,12 @@ namespace DNest5
 class CommandLineOptions
 {
 	private:
-        double temperature;
+        std::vector<double> temperatures;
         bool abc;
         double abc_fraction;
+        double memory_budget;
+        int num_threads;
+        int num_replicates;
 
 	public:
         // Construct
@@ -28,10 +32,18 @@ class CommandLineOptions
 		// Print help message
 		void print_help() const;
 
+        // Parse a list (t1,t2,...) or a range (min:max:num) of temperatures
+        static std::vector<double> parse_temperatures(const std::string& arg);
+
         // Getters
-        inline double get_temperature() const { return temperature; }
+        inline double get_temperature() const { return temperatures[0]; }
+        inline const std::vector<double>& get_temperatures() const
+        { return temperatures; }
         inline bool get_abc() const { return abc; }
         inline double get_abc_fraction() const { return abc_fraction; }
+        inline double get_memory_budget() const { return memory_budget; }
+        inline int get_num_threads() const { return num_threads; }
+        inline int get_num_replicates() const { return num_replicates; }
 };
 
 } // namespace DNest5
@@ -0,0 +1,49 @@
+#ifndef DNest5_Compression_h
+#define DNest5_Compression_h
+
+#include <string>
+#include <vector>
+
+namespace DNest5
+{
+
+/*
+* Optional compression of the params column of the particles table.
+* Compressed params are stored as a BLOB that starts with a zero byte, which
+* the text from to_string() never does, so decode() accepts either and old
+* databases still work.
+*/
+class Compression
+{
+    private:
+        bool use_zlib;
+
+        // Running totals for the report
+        unsigned long long raw_bytes, stored_bytes;
+        double seconds;
+
+        // Zero byte, then the uncompressed size (little endian)
+        static constexpr int header_size = 5;
+
+    public:
+
+        // Name as in options.yaml ("none" or "zlib"). Exits on anything else.
+        Compression(const std::string& name = "none");
+
+        bool enabled() const { return use_zlib; }
+
+        // Compress the output of to_string(). Returns the text unchanged
+        // if compressing it would not save anything.
+        std::vector<char> encode(const std::string& text);
+
+        // Get the to_string() text back from a params value
+        static std::string decode(const std::vector<char>& value);
+
+        // Compression ratio and CPU time so far
+        std::string report() const;
+};
+
+} // namespace
+
+#endif
+
@@ -1,7 +1,14 @@
 #ifndef DNest5_Database_h
 #define DNest5_Database_h
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
 #include <sqlite_modern_cpp/hdr/sqlite_modern_cpp.h>
+#include <string>
+#include <thread>
 
 namespace DNest5
 {
@@ -10,21 +17,101 @@ namespace DNest5
 class Database
 {
     private:
+        std::string filename;
+
+        // If set, db is in memory and copied to filename this often (seconds)
+        std::optional<double> snapshot_interval;
+        double max_data_loss;
+
         sqlite::database db;
         void pragmas();
+        int schema_version();
+        void migrate();
         void create_tables();
         void create_indexes();
         void create_views();
         void clear_previous();
 
+        // Background work: checkpointing an on-disk database (on its own
+        // connection; automatic checkpoints are turned off so that they
+        // never run inside the sampler's commits), or snapshotting an
+        // in-memory one. Holding background_mutex means doing this work.
+        std::thread background_thread;
+        std::mutex background_mutex;
+        std::condition_variable background_cv;
+        bool stopping;
+        void checkpoint_loop();
+        void snapshot_loop();
+
+        // Completion time of the last snapshot, in steady_clock nanoseconds
+        std::atomic<std::int64_t> last_snapshot;
+
+        // Copy one database into another with the online backup API, a few
+        // pages at a time so that other users of the source get a turn
+        static int copy(sqlite::database& from, sqlite::database& to,
+                        int pages_per_step);
+
+        // Snapshot with background_mutex already held
+        void snapshot_locked();
+
     public:
-        Database();
+        Database(const std::string& _filename = "output/dnest5.db",
+                 std::optional<double> _snapshot_interval = std::optional<double>{},
+                 double _max_data_loss = 60.0);
+        ~Database();
+
+        bool in_memory() const { return snapshot_interval.has_value(); }
+
+        // Copy an in-memory database to disk now. Does nothing for an
+        // on-disk database.
+        void snapshot();
+
+        // Snapshot now if the last one is older than max_data_loss. Call this
+        // between transactions.
+        void limit_data_loss();
+
+        // Age of the data on disk, for an in-memory database
+        double seconds_since_snapshot() const;
 
         int num_full_particles(int sampler_id);
 
-        // Friend
+        // The schema version written by this code
+        static constexpr int current_schema_version = 6;
+
+        // Tuning parameters. Benchmarks/DatabaseBenchmark.cpp times the
+        // inserts and postprocess's reads with them.
+        static constexpr int page_size = 8192;
+        static constexpr int cache_size_kib = 65536;
+        static constexpr long long mmap_size = 268435456;
+
+        // Apply the read-side tuning pragmas to another connection
+        static void reader_pragmas(sqlite::database& connection);
+
+        // WAL limits. A passive checkpoint is attempted every
+        // checkpoint_interval_ms once the WAL exceeds wal_checkpoint_bytes.
+        // A WAL that has been fully checkpointed but is still larger than
+        // wal_size_limit is truncated, which only succeeds when no reader
+        // is using it.
+        static constexpr int checkpoint_interval_ms = 1000;
+        static constexpr std::uintmax_t wal_checkpoint_bytes = 16777216;
+        static constexpr std::uintmax_t wal_size_limit = 67108864;
+        static constexpr int busy_timeout_ms = 10000;
+
+        // Pages copied per backup step when snapshotting
+        static constexpr int snapshot_pages_per_step = 256;
+
+        // Checkpoint the WAL on a connection. Returns true if every frame
+        // was copied (and, for truncate, the WAL was emptied).
+        static bool checkpoint(sqlite::database& connection, bool truncate);
+
+        // Current size of the WAL file, in bytes
+        std::uintmax_t wal_size() const;
+
+        // Friends
         template<typename T>
         friend class Sampler;
+
+        friend class DatabaseBenchmark;
 };
 
 } // namespace
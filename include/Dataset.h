@@ -0,0 +1,70 @@
+#ifndef DNest5_Dataset_h
+#define DNest5_Dataset_h
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace DNest5
+{
+
+/*
+* A table of doubles that is memory-mapped read-only, so every thread and
+* every process on the machine reading the same file shares one copy in
+* the page cache.
+*
+* Opening a text file (numbers separated by whitespace or commas, one row
+* per line, '#' comments and a non-numeric header line allowed) converts it
+* to filename + ".bin" the first time, and again whenever the text file is
+* newer. The binary file is a 64-byte header followed by the columns, each
+* starting on a 64-byte boundary, in native byte order.
+*/
+class Dataset
+{
+    private:
+        const char* map;
+        std::size_t map_size;
+        std::size_t num_rows, num_columns;
+
+        // Bytes from the start of one column to the next
+        std::size_t stride;
+
+        static constexpr std::size_t header_size = 64;
+        static constexpr std::size_t alignment = 64;
+
+        void open_binary(const std::string& filename);
+        void unmap();
+
+        // Whether filename starts with the binary header
+        static bool is_binary(const std::string& filename);
+
+    public:
+
+        // Empty
+        Dataset();
+
+        // Open a binary file, or a text file via its binary version
+        Dataset(const std::string& filename);
+
+        Dataset(const Dataset& other) = delete;
+        Dataset& operator = (const Dataset& other) = delete;
+        Dataset(Dataset&& other);
+        Dataset& operator = (Dataset&& other);
+        ~Dataset();
+
+        // Write the binary version of a text file. The output appears
+        // atomically, so concurrent converters are harmless.
+        static void convert(const std::string& text_file,
+                            const std::string& binary_file);
+
+        std::size_t size() const { return num_rows; }
+        std::size_t columns() const { return num_columns; }
+
+        // Column j (zero-based), 64-byte aligned
+        std::span<const double> column(std::size_t j) const;
+};
+
+} // namespace
+
+#endif
+
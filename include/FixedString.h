@@ -0,0 +1,44 @@
+#ifndef DNest5_FixedString_h
+#define DNest5_FixedString_h
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+namespace DNest5
+{
+
+/*
+* A string literal that can be a template argument, as in param<"m">().
+* N includes the terminating null character.
+*/
+template<std::size_t N>
+struct FixedString
+{
+    char value[N];
+
+    constexpr FixedString(const char (&s)[N])
+    {
+        std::copy_n(s, N, value);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view(value, N - 1);
+    }
+};
+
+// Position of name in a constexpr list of names, or -1 if it isn't there
+template<typename Names>
+constexpr int index_of(const Names& names, std::string_view name)
+{
+    for(int i=0; i<int(std::size(names)); ++i)
+        if(names[i] == name)
+            return i;
+    return -1;
+}
+
+} // namespace
+
+#endif
+
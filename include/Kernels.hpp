@@ -0,0 +1,162 @@
+#ifndef DNest5_Kernels_hpp
+#define DNest5_Kernels_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <Tools/Misc.hpp>
+
+// Define DNest5_NO_SIMD to use the scalar versions everywhere
+#if __has_include(<experimental/simd>) && !defined(DNest5_NO_SIMD)
+#include <experimental/simd>
+#define DNest5_SIMD
+#endif
+
+/*
+* Vectorised building blocks for log likelihoods over contiguous arrays.
+* Each kernel is written once as a generic lambda and run on
+* std::experimental::native_simd<double> vectors, then on the scalars left
+* over (or on scalars only, without <experimental/simd>). The sums are
+* reassociated, so results can differ from a scalar loop in the last bits.
+*
+* libstdc++ evaluates exp, log and friends on simd types one element at a
+* time, which is slower than a plain loop, so kernels that need them pass
+* vectorise = false until that changes.
+*/
+namespace DNest5::Kernels
+{
+
+#ifdef DNest5_SIMD
+namespace stdx = std::experimental;
+using Vec = stdx::native_simd<double>;
+#endif
+
+// Load a Vec or a double starting at p
+template<typename V>
+inline V load(const double* p)
+{
+    if constexpr(std::is_same_v<V, double>)
+        return *p;
+#ifdef DNest5_SIMD
+    else
+        return V(p, stdx::element_aligned);
+#endif
+}
+
+// Sum of f(i, V()) over i = 0, width, 2*width, ..., then f(i, double())
+// for the remainder
+template<bool vectorise = true, typename F>
+inline double sum_over(std::size_t n, F&& f)
+{
+    double total = 0.0;
+    std::size_t i = 0;
+#ifdef DNest5_SIMD
+    if constexpr(vectorise)
+    {
+        Vec acc = 0.0;
+        for(; i + Vec::size() <= n; i += Vec::size())
+            acc += f(i, Vec());
+        total = stdx::reduce(acc);
+    }
+#endif
+    for(; i<n; ++i)
+        total += f(i, double());
+    return total;
+}
+
+// sum (x - mu)^2
+inline double sum_squared_deviations(std::span<const double> xs, double mu)
+{
+    return sum_over(xs.size(), [&](std::size_t i, auto v)
+    {
+        auto d = load<decltype(v)>(&xs[i]) - mu;
+        return d*d;
+    });
+}
+
+// sum (x - y)^2
+inline double sum_squared_differences(std::span<const double> xs,
+                                      std::span<const double> ys)
+{
+    return sum_over(xs.size(), [&](std::size_t i, auto v)
+    {
+        using V = decltype(v);
+        auto d = load<V>(&xs[i]) - load<V>(&ys[i]);
+        return d*d;
+    });
+}
+
+// sum (y - (m*x + b))^2, the residuals of a straight line
+inline double sum_squared_residuals(std::span<const double> xs,
+                                    std::span<const double> ys,
+                                    double m, double b)
+{
+    return sum_over(xs.size(), [&](std::size_t i, auto v)
+    {
+        using V = decltype(v);
+        auto r = load<V>(&ys[i]) - (m*load<V>(&xs[i]) + b);
+        return r*r;
+    });
+}
+
+// sum log Normal(x | mu, sigma^2)
+inline double gaussian_logpdf_sum(std::span<const double> xs,
+                                  double mu, double sigma)
+{
+    double n = xs.size();
+    return -0.5*n*log(2.0*M_PI*sigma*sigma)
+                - 0.5*sum_squared_deviations(xs, mu)/(sigma*sigma);
+}
+
+// sum log Student-t(x | mu, sigma, nu)
+inline double student_t_logpdf_sum(std::span<const double> xs,
+                                   double mu, double sigma, double nu)
+{
+    double n = xs.size();
+    double c = lgamma(0.5*(nu + 1.0)) - lgamma(0.5*nu)
+                    - 0.5*log(M_PI*nu) - log(sigma);
+    double scale = 1.0/(nu*sigma*sigma);
+    double s = sum_over<false>(xs.size(), [&](std::size_t i, auto v)
+    {
+        auto d = load<decltype(v)>(&xs[i]) - mu;
+        return log1p(scale*d*d);
+    });
+    return n*c - 0.5*(nu + 1.0)*s;
+}
+
+// log sum exp(x)
+inline double logsumexp(std::span<const double> xs)
+{
+    if(xs.size() == 0)
+        return Tools::minus_infinity;
+    double max = *std::max_element(xs.begin(), xs.end());
+    if(max == Tools::minus_infinity)
+        return max;
+    double s = sum_over<false>(xs.size(), [&](std::size_t i, auto v)
+    {
+        return exp(load<decltype(v)>(&xs[i]) - max);
+    });
+    return max + log(s);
+}
+
+// sum over i of 100 (x[i+1] - x[i]^2)^2 + (1 - x[i])^2
+inline double rosenbrock_sum(std::span<const double> xs)
+{
+    if(xs.size() < 2)
+        return 0.0;
+    return sum_over(xs.size() - 1, [&](std::size_t i, auto v)
+    {
+        using V = decltype(v);
+        auto x = load<V>(&xs[i]);
+        auto a = load<V>(&xs[i+1]) - x*x;
+        auto b = 1.0 - x;
+        return 100.0*a*a + b*b;
+    });
+}
+
+} // namespace
+
+#endif
+
@@ -32,6 +32,16 @@ class Levels
         // Statistics
         std::vector<unsigned long long> exceeds, visits, accepts, tries;
 
+        // Log of the proposal scale used at each level, and the accepts
+        // and tries when it was last tuned
+        std::vector<double> log_scales;
+        std::vector<unsigned long long> tuned_accepts, tuned_tries;
+        bool scales_frozen;
+
+        // Likelihood evaluations of proposals from each level, and how
+        // many of them stopped early because they couldn't beat it
+        std::vector<unsigned long long> evaluations, early_exits;
+
         // Stash of (logl_tb) pairs for new level creation
         std::vector<Pair> stash;
 
@@ -50,12 +60,19 @@ class Levels
         // Record stats
         template<typename T>
         inline void record_stats(const Particle<T>& particle, bool accepted);
+        inline void record_evaluation(int level, bool exited_early);
 
         // Revise logxs
         void revise();
 
-        // Adjust exceeds, visits, accepts, tries of the given level
-        void adjust(int level, int e, int v, int a, int t);
+        // Tune the proposal scales towards a target acceptance rate, if
+        // Options ask for it. They are frozen for good once levels are
+        // done building, so that the proposals are fixed from then on.
+        void tune_scales();
+
+        // Adjust exceeds, visits, accepts, tries, evaluations and early
+        // exits of the given level
+        void adjust(int level, int e, int v, int a, int t, int ev, int ee);
 
         // Clear the stash
         void clear_stash();
@@ -83,6 +100,13 @@ class Levels
         { return tries[level]; }
         inline bool get_push_is_active() const
         { return push_is_active; }
+        inline int get_stash_size() const { return int(stash.size()); }
+        inline double get_log_scale(int level) const
+        { return log_scales[level]; }
+        inline unsigned long long get_evaluations(int level) const
+        { return evaluations[level]; }
+        inline unsigned long long get_early_exits(int level) const
+        { return early_exits[level]; }
 };
 
 /* TEMPLATE IMPLEMENTATIONS */
@@ -110,6 +134,13 @@ inline void Levels::record_stats(const Particle<T>& particle, bool accepted)
     ++tries[level];
 }
 
+inline void Levels::record_evaluation(int level, bool exited_early)
+{
+    ++evaluations[level];
+    if(exited_early)
+        ++early_exits[level];
+}
+
 
 } // namespace
 
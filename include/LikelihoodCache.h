@@ -0,0 +1,62 @@
+#ifndef DNest5_LikelihoodCache_h
+#define DNest5_LikelihoodCache_h
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace DNest5
+{
+
+/*
+* A bounded cache of log likelihoods keyed on a hash of the model's state,
+* evicting the least recently used entry when full. Sampler keeps one per
+* thread, so there is no locking. A capacity of zero disables it.
+*
+* Only worthwhile for slow, deterministic likelihoods: a hit is trusted
+* without comparing states, so the hash must be a good 64-bit one (see
+* hash() below).
+*/
+class LikelihoodCache
+{
+    private:
+        std::size_t capacity;
+
+        // Most recently used at the front
+        std::list<std::pair<std::uint64_t, double>> entries;
+        std::unordered_map<std::uint64_t,
+                           decltype(entries)::iterator> index;
+
+        unsigned long long hits, misses;
+
+    public:
+
+        LikelihoodCache(std::size_t _capacity = 0);
+
+        bool enabled() const { return capacity > 0; }
+
+        // Look up a key, counting a hit or a miss
+        std::optional<double> find(std::uint64_t key);
+
+        // Add or refresh an entry
+        void insert(std::uint64_t key, double logl);
+
+        unsigned long long get_hits() const { return hits; }
+        unsigned long long get_misses() const { return misses; }
+
+        // Hit rate of a set of caches
+        static std::string report(std::span<const LikelihoodCache> caches);
+
+        // Hash of the bit patterns of some doubles
+        static std::uint64_t hash(std::span<const double> values);
+};
+
+} // namespace
+
+#endif
+
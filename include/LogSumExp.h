@@ -0,0 +1,67 @@
+#ifndef DNest5_LogSumExp_h
+#define DNest5_LogSumExp_h
+
+#include <cmath>
+#include <Tools/Misc.hpp>
+
+namespace DNest5
+{
+
+/*
+* A running log-sum-exp, for when the terms are too many to keep in memory.
+* Each term exp(logw) can carry a value f, and the weighted mean of f is
+* accumulated alongside the total.
+*/
+class LogSumExp
+{
+    private:
+
+        // Largest logw so far, and sums scaled by exp(-max_logw)
+        double max_logw;
+        double sum;
+        double sum_f;
+
+    public:
+
+        // Starts empty, with a log total of minus infinity
+        LogSumExp();
+
+        // Add a term
+        inline void add(double logw, double f = 0.0);
+
+        // Combine with another accumulator (e.g., from another thread)
+        void merge(const LogSumExp& other);
+
+        // log(sum exp(logw))
+        double get_log_total() const;
+
+        // sum exp(logw) f / sum exp(logw)
+        double get_mean() const;
+};
+
+/* INLINE IMPLEMENTATIONS */
+
+inline void LogSumExp::add(double logw, double f)
+{
+    if(logw == Tools::minus_infinity)
+        return;
+
+    if(logw > max_logw)
+    {
+        double scale = exp(max_logw - logw);
+        sum   = sum*scale + 1.0;
+        sum_f = sum_f*scale + f;
+        max_logw = logw;
+    }
+    else
+    {
+        double w = exp(logw - max_logw);
+        sum   += w;
+        sum_f += w*f;
+    }
+}
+
+} // namespace
+
+#endif
+
@@ -0,0 +1,100 @@
+#ifndef DNest5_Logger_h
+#define DNest5_Logger_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace DNest5
+{
+
+enum class LogLevel { debug, info, warning, error, quiet };
+
+using LogValue = std::variant<bool, long long, unsigned long long, double,
+                              std::string>;
+using LogFields = std::vector<std::pair<std::string, LogValue>>;
+
+// One event: a name, a message for people, and fields for machines
+struct LogRecord
+{
+    LogLevel level;
+    std::string event;
+    std::string message;
+    LogFields fields;
+    double seconds;
+};
+
+/*
+* The sampler's messages. log() only queues a record, and a background
+* thread writes whatever has queued up to stdout with one flush per batch,
+* either as the messages or as one JSON object per line. Records below the
+* level are dropped before they are queued, and progress messages can be
+* limited to one round per interval. There is one per process, set up by
+* Options, as is the output precision.
+*/
+class Logger
+{
+    private:
+        std::atomic<LogLevel> level;
+        std::atomic<bool> json;
+        double round_interval;
+        std::chrono::steady_clock::time_point start_time, last_round;
+
+        // Records waiting for the writer
+        std::vector<LogRecord> queue;
+        std::mutex mutex;
+        std::condition_variable queued, written;
+        bool writing, stopping;
+        std::thread writer;
+
+        Logger();
+        void write_loop();
+        static std::string render(const LogRecord& record, bool as_json);
+
+    public:
+        ~Logger();
+
+        static Logger& get();
+
+        // Levels are "debug", "info", "warning", "error" or "quiet", and
+        // formats "text" or "json". Rounds are logged at most once per
+        // round_interval seconds.
+        void configure(const std::string& _level, const std::string& format,
+                       double _round_interval);
+
+        bool enabled(LogLevel _level) const { return _level >= level; }
+
+        // Whether to log the current round's progress. Call once per round.
+        bool round_due();
+
+        void log(LogLevel _level, std::string event, std::string message,
+                 LogFields fields = {});
+
+        // Block until everything logged so far has been written
+        void flush();
+
+        // A stream for building messages, at the output precision
+        static std::stringstream stream();
+};
+
+// Shorthand
+inline void log_event(LogLevel level, std::string event, std::string message,
+                      LogFields fields = {})
+{
+    Logger& logger = Logger::get();
+    if(logger.enabled(level))
+        logger.log(level, std::move(event), std::move(message),
+                   std::move(fields));
+}
+
+} // namespace
+
+#endif
+
@@ -1,12 +1,20 @@
 #ifndef DNest5_Misc_h
 #define DNest5_Misc_h
 
+#include <Tools/RNG.hpp>
+
 namespace DNest5
 {
 
 // Delete files in the output directory
 void clear_output_dir();
 
+// Draw from a Gamma(shape, 1) distribution
+double rand_gamma(Tools::RNG& rng, double shape);
+
+// Draw from a Beta(a, b) distribution
+double rand_beta(Tools::RNG& rng, double a, double b);
+
 } // namespace
 
 #endif
@@ -0,0 +1,120 @@
+#ifndef DNest5_Model_h
+#define DNest5_Model_h
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include "ThreadPool.h"
+#include <Tools/RNG.hpp>
+
+namespace DNest5
+{
+
+/*
+* What Sampler<T> and postprocess<T> need from a model type T. Models are
+* used by value and every call is resolved at compile time, so nothing
+* here is virtual. UniformModel satisfies it as long as the derived class
+* provides us_to_params() and log_likelihood().
+*
+* log_likelihood() may instead take a ThreadPool& (see UsesThreadPool).
+*/
+template<typename T>
+concept Model = std::copy_constructible<T>
+                && std::is_copy_assignable_v<T>
+                && requires(T t, const T& ct, Tools::RNG& rng)
+{
+    // Generate from the prior
+    T(rng);
+
+    // Metropolis proposal, returning the log of the Hastings factor
+    { t.perturb(rng) } -> std::convertible_to<double>;
+
+    requires requires
+    {
+        { ct.log_likelihood() } -> std::convertible_to<double>;
+    } || requires(ThreadPool& pool)
+    {
+        { ct.log_likelihood(pool) } -> std::convertible_to<double>;
+    };
+
+    // One CSV row of parameters, for the database and posterior.csv
+    { ct.to_string() } -> std::convertible_to<std::string>;
+    { T::parameter_names.csv_header() } -> std::convertible_to<std::string>;
+};
+
+/*
+* Models whose perturb() also takes a scale (multiplying the step sizes)
+* get one per level, tuned while levels are built if Options ask for it.
+* UniformModel does.
+*/
+template<typename T>
+concept ScalesProposals = requires(T t, Tools::RNG& rng)
+{
+    { t.perturb(rng, 1.0) } -> std::convertible_to<double>;
+};
+
+/*
+* Models whose log_likelihood() takes the sampler's ThreadPool, to split
+* up its own work (e.g. a loop over the data) with pool.parallel_for().
+* That pool is shared by all threads and the caller helps with its own
+* work, so nothing is oversubscribed however the work is nested.
+*/
+template<typename T>
+concept UsesThreadPool = requires(const T& t, ThreadPool& pool)
+{
+    { t.log_likelihood(pool) } -> std::convertible_to<double>;
+};
+
+/*
+* Models that can tell part way through that their log likelihood is below
+* a threshold, e.g. when it is a sum of non-positive terms. They return
+* nullopt in that case and the log likelihood otherwise. Sampler passes the
+* threshold of the particle's level, so most proposals at high levels stop
+* early. Sampler doesn't take models that are also UsesThreadPool.
+*/
+template<typename T>
+concept ExitsEarly = requires(const T& t, double threshold)
+{
+    { t.log_likelihood(threshold) } -> std::same_as<std::optional<double>>;
+};
+
+/*
+* Models that evaluate several log likelihoods in one call, setting
+* logls[i] to models[i]->log_likelihood(). SimulatorModel does. Sampler
+* hands these a batch of proposals at a time when batch_size > 1.
+*/
+template<typename T>
+concept BatchedLikelihood = requires(std::span<const T* const> models,
+                                     std::span<double> logls)
+{
+    T::log_likelihood_batch(models, logls);
+};
+
+/*
+* Models with a 64-bit hash() of everything their likelihood depends on
+* can have log likelihoods looked up in a LikelihoodCache instead of
+* recomputed. UniformModel hashes its coordinates.
+*/
+template<typename T>
+concept HashesState = requires(const T& t)
+{
+    { t.hash() } -> std::convertible_to<std::uint64_t>;
+};
+
+/*
+* Models with static data provide load_data(), callable with no arguments.
+* Sampler and postprocess call it once up front, before any model objects
+* exist or any threads start.
+*/
+template<typename T>
+concept LoadsData = requires
+{
+    T::load_data();
+};
+
+} // namespace
+
+#endif
+
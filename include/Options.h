@@ -7,6 +7,7 @@
 #include <iomanip>
 #include <iostream>
 #include <optional>
+#include <string>
 #include <yaml-cpp/yaml.h>
 
 namespace DNest5
@@ -29,6 +30,18 @@ class Options
         double beta;
         int max_num_saves;
         int rng_seed;
+        std::string compression;
+        std::optional<double> snapshot_interval;
+        double max_data_loss;
+        bool adaptive_proposals;
+        int batch_size;
+        int likelihood_cache_size;
+        int num_tries;
+        std::optional<int> helper_threads;
+        std::optional<double> status_interval;
+        std::string log_level;
+        std::string log_format;
+        double log_interval;
 
     public:
 
@@ -42,7 +55,19 @@ class Options
                 double _lambda = 10.0,
                 double _beta = 100.0,
                 int _max_num_saves = 100000,
-                std::optional<int> _rng_seed = std::optional<int>{});
+                std::optional<int> _rng_seed = std::optional<int>{},
+                std::string _compression = "none",
+                std::optional<double> _snapshot_interval = std::optional<double>{},
+                double _max_data_loss = 60.0,
+                bool _adaptive_proposals = false,
+                int _batch_size = 1,
+                int _likelihood_cache_size = 0,
+                int _num_tries = 1,
+                std::optional<int> _helper_threads = std::optional<int>{},
+                std::optional<double> _status_interval = 1.0,
+                std::string _log_level = "info",
+                std::string _log_format = "text",
+                double _log_interval = 0.0);
 
         // Constructor that loads from a YAML file
         Options(const char* yaml_file);
@@ -1,11 +1,17 @@
 #ifndef DNest5_PostprocessingImpl_h
 #define DNest5_PostprocessingImpl_h
 
+#include "Compression.h"
+#include "Database.h"
+#include "Misc.h"
+#include "LogSumExp.h"
+#include "Model.h"
 #include "Options.h"
+#include "Particle.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <cmath>
-#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <sqlite_modern_cpp/hdr/sqlite_modern_cpp.h>
@@ -17,20 +23,162 @@
 namespace DNest5
 {
 
-using Tools::logsumexp, Tools::logdiffexp, Tools::minus_infinity, Tools::RNG;
+using Tools::logdiffexp, Tools::minus_infinity, Tools::RNG;
+
+// A block of consecutive particles from the sorted scan, kept as parallel
+// arrays so that the per-particle arithmetic vectorises
+struct ParticleChunk
+{
+    // Position of the first particle in the whole scan
+    long long start;
+
+    std::vector<int> ids, levels, ranks;
+    std::vector<double> logls, logms, logxs;
+    std::vector<char> full;
+
+    inline int size() const { return int(ids.size()); }
+
+    static constexpr int capacity = 65536;
+    static constexpr int bytes_per_particle = 3*sizeof(int)
+                                                + 3*sizeof(double) + 1;
+};
+
+// Bring the scanned table in posterior.db up to date with dnest5.db, and
+// return the number of particles in each level. Must be called inside a
+// transaction on both connections.
+inline std::vector<double> update_scanned(sqlite::database& reader,
+                                          sqlite::database& db,
+                                          int max_particle_id,
+                                          const std::vector<Pair>& level_pairs)
+{
+    int num_levels = int(level_pairs.size());
+
+    db <<
+"CREATE TABLE IF NOT EXISTS scanned\n\
+    (id    INTEGER NOT NULL PRIMARY KEY,\n\
+     level INTEGER NOT NULL,\n\
+     logl  REAL NOT NULL,\n\
+     tb    REAL NOT NULL,\n\
+     full  INTEGER NOT NULL);";
+    db <<
+"CREATE INDEX IF NOT EXISTS scanned_logl_tb_idx\n\
+ON scanned (logl, tb, level, full);";
+    db <<
+"CREATE TABLE IF NOT EXISTS scanned_levels\n\
+    (id            INTEGER NOT NULL PRIMARY KEY,\n\
+     logl          REAL NOT NULL,\n\
+     tb            REAL NOT NULL,\n\
+     num_particles INTEGER NOT NULL);";
+
+    // What was scanned last time. It is only reused if it describes the
+    // same run: the same levels so far, and the same last particle.
+    int last_particle_id = 0;
+    db << "SELECT MAX(id) FROM scanned;" >> last_particle_id;
+    bool valid = last_particle_id <= max_particle_id;
+    std::vector<double> counts;
+    db << "SELECT id, logl, tb, num_particles FROM scanned_levels ORDER BY id;"
+       >> [&](int id, double logl, double tb, double n)
+        {
+            if(id >= num_levels || id != int(counts.size())
+                    || level_pairs[id] != Pair{logl, tb})
+                valid = false;
+            counts.push_back(n);
+        };
+    if(valid && last_particle_id > 0)
+    {
+        double logl = minus_infinity, tb = 0.0;
+        db << "SELECT logl, tb FROM scanned WHERE id = ?;" << last_particle_id
+           >> [&](double _logl, double _tb) { logl = _logl; tb = _tb; };
+        int count = 0;
+        reader << "SELECT COUNT(*) FROM particles\
+                   WHERE id = ? AND logl = ? AND tb = ?;"
+               << last_particle_id << logl << tb >> count;
+        valid = count == 1;
+    }
+    if(!valid)
+    {
+        std::cout << "Discarding stale postprocessing state." << std::endl;
+        db << "DELETE FROM scanned;";
+        db << "DELETE FROM scanned_levels;";
+        last_particle_id = 0;
+        counts.clear();
+    }
+    int old_num_levels = int(counts.size());
+    counts.resize(num_levels, 0.0);
+
+    // Move particles up into levels created since last time, and recount
+    // the levels involved. Level pairs increase with level ID, so each
+    // count is a range of scanned_logl_tb_idx.
+    if(old_num_levels > 0 && num_levels > old_num_levels)
+    {
+        for(int j=old_num_levels; j<num_levels; ++j)
+        {
+            db << "UPDATE scanned SET level = ? WHERE (logl, tb) >= (?, ?);"
+               << j << std::get<0>(level_pairs[j]) << std::get<1>(level_pairs[j]);
+        }
+        std::vector<double> above(num_levels + 1, 0.0);
+        for(int j=old_num_levels-1; j<num_levels; ++j)
+        {
+            db << "SELECT COUNT(*) FROM scanned WHERE (logl, tb) >= (?, ?);"
+               << std::get<0>(level_pairs[j]) << std::get<1>(level_pairs[j])
+               >> above[j];
+        }
+        for(int j=old_num_levels-1; j<num_levels; ++j)
+            counts[j] = above[j] - above[j+1];
+    }
+
+    // Add the new particles, putting each one in the highest level whose
+    // pair does not exceed its own
+    long long num_new = 0;
+    auto insert_scanned = db << "INSERT INTO scanned VALUES (?, ?, ?, ?, ?);";
+    reader << "SELECT id, logl, tb, params IS NOT NULL FROM particles\
+               WHERE id > ? AND id <= ?;"
+           << last_particle_id << max_particle_id >>
+        [&](int id, double logl, double tb, bool full)
+        {
+            Pair pair{logl, tb};
+            auto it = std::upper_bound(level_pairs.begin(), level_pairs.end(),
+                                       pair, [](const Pair& a, const Pair& b)
+                                       { return a < b; });
+            int level = std::max(int(it - level_pairs.begin()) - 1, 0);
+            insert_scanned << id << level << logl << tb << full;
+            insert_scanned++;
+            counts[level] += 1.0;
+            ++num_new;
+        };
+    insert_scanned.used(true);
+
+    db << "DELETE FROM scanned_levels;";
+    for(int j=0; j<num_levels; ++j)
+    {
+        db << "INSERT INTO scanned_levels VALUES (?, ?, ?, ?);"
+           << j << std::get<0>(level_pairs[j]) << std::get<1>(level_pairs[j])
+           << counts[j];
+    }
+
+    std::cout << "Scanned " << num_new << " new particles." << std::endl;
+    return counts;
+}
 
 template<typename T>
 inline void postprocess(const CommandLineOptions& options)
 {
+    static_assert(Model<T>, "T does not provide what postprocess needs.");
+
     std::cout << "--------------------\n";
     std::cout << "Begin postprocessing\n";
     std::cout << "--------------------\n" << std::endl;
 
+    // Some models name their parameters after seeing the data
+    if constexpr(LoadsData<T>)
+        T::load_data();
+
     // A read-only database connection
     sqlite::database reader("output/dnest5.db",
                             sqlite::sqlite_config { sqlite::OpenFlags::READONLY,
                                                     nullptr,
                                                     sqlite::Encoding::ANY });
+    Database::reader_pragmas(reader);
 
     // A writing connection to posterior.db
     sqlite::database db("output/posterior.db");
@@ -43,27 +191,63 @@ inline void postprocess(const CommandLineOptions& options)
      logx REAL NOT NULL,\n\
      logm REAL NOT NULL,\n\
      logp REAL);";
-    db << "DELETE FROM particles;";
+    db <<
+"CREATE TABLE IF NOT EXISTS temperatures\n\
+    (temperature REAL NOT NULL PRIMARY KEY,\n\
+     logz        REAL NOT NULL,\n\
+     info        REAL NOT NULL,\n\
+     ess         INTEGER NOT NULL);";
+    db <<
+"CREATE TABLE IF NOT EXISTS replicates\n\
+    (id   INTEGER NOT NULL PRIMARY KEY,\n\
+     logz REAL NOT NULL,\n\
+     info REAL NOT NULL);";
+    db << "DELETE FROM temperatures;";
+    db << "DELETE FROM replicates;";
     db << "COMMIT;";
-    db << "VACUUM;";
 
-    // Get maximum particle ID and number of levels and use it for truncation
-    int max_particle_id, max_level_id;
+    // Get maximum particle ID and use it for truncation
+    int max_particle_id;
     reader << "BEGIN;";
     reader << "SELECT MAX(id) FROM particles;" >> max_particle_id;
-    reader << "SELECT MAX(id) FROM levels;" >> max_level_id;
 
     // Load levels into a vector
-    std::vector<double> level_logxs, level_num_particles;
-    reader << "SELECT logx, num_particles\
-               FROM levels l LEFT JOIN particles_per_level ppl\
-               ON l.id = ppl.level;" >>
-        [&](double logx, int n)
+    std::vector<double> level_logxs;
+    std::vector<double> level_exceeds, level_visits;
+    std::vector<Pair> level_pairs;
+    reader << "SELECT logx, logl, tb, exceeds, visits FROM levels\
+               ORDER BY id;" >>
+        [&](double logx, double logl, double tb, double exceeds, double visits)
         {
             level_logxs.push_back(logx);
-            level_num_particles.push_back(n);
+            level_pairs.push_back({logl, tb});
+            level_exceeds.push_back(exceeds);
+            level_visits.push_back(visits);
         };
 
+    // Likelihood evaluations so far (older databases don't have them)
+    double likelihood_calls = 0.0;
+    int has_likelihood_calls;
+    reader << "SELECT COUNT(*) FROM pragma_table_info('samplers')\
+               WHERE name = 'likelihood_calls';" >> has_likelihood_calls;
+    if(has_likelihood_calls > 0)
+        reader << "SELECT TOTAL(likelihood_calls) FROM samplers;"
+               >> likelihood_calls;
+
+    // Only particles saved since the last run need to be read from
+    // dnest5.db. The scanned table holds the level assignment of every
+    // particle seen so far, so later passes read from that instead.
+    db << "BEGIN;";
+    std::vector<double> level_num_particles
+                = update_scanned(reader, db, max_particle_id, level_pairs);
+    db << "COMMIT;";
+
+    // That is all that needs a consistent snapshot of dnest5.db. Ending the
+    // read transaction here lets the sampler's checkpoints get past it.
+    // Particles are never modified once saved, so the params read at the
+    // end are the same either way.
+    reader << "COMMIT;";
+
     // Compute log-mass between levels
     std::vector<double> level_logms;
     // m_i = X_i - X_{i+1}
@@ -72,106 +256,321 @@ inline void postprocess(const CommandLineOptions& options)
         level_logms.push_back(logdiffexp(level_logxs[i], level_logxs[i+1]));
     level_logms.push_back(logdiffexp(level_logxs.back(), minus_infinity));
 
-    // Compute log-masses of the particles
-    int rank = 0;
-    int old_level = 0;
-    // Parallel vectors of particle information
-    std::vector<int> particle_ids; std::vector<double> logms, logls, logxs;
-    std::deque<bool> is_full;
-    reader << "SELECT p.id, llp.level, p.logl, p.params IS NOT NULL\
-                            FROM particles p INNER JOIN\
-                            levels_leq_particles llp ON p.id=llp.particle\
-                            WHERE p.id <= ? AND llp.level <= ?\
-                            ORDER BY llp.level, logl, tb;"
-       << max_particle_id << max_level_id >>
-        [&](int particle_id, int level, double logl, bool full)
-        {
-            if(level != old_level)
+    // Total number of particles, for ABC mode and the memory budget
+    int num_levels = int(level_logxs.size());
+    long long num_particles = 0;
+    for(double n: level_num_particles)
+        num_particles += (long long)n;
+
+    // Per-level constants for the particles. With c_j = M_j/(N_j X_j),
+    // the particle of rank r within level j has
+    // X = X_j - (r + 0.5) M_j/N_j = X_j (1 - c_j (r + 0.5)).
+    std::vector<double> particle_logms(num_levels), level_cs(num_levels);
+    for(int j=0; j<num_levels; ++j)
+    {
+        particle_logms[j] = level_logms[j] - log(level_num_particles[j]);
+        level_cs[j] = exp(level_logms[j] - level_logxs[j])
+                            /level_num_particles[j];
+    }
+
+    ThreadPool pool(options.get_num_threads());
+
+    // Keep the particles in RAM between passes if they fit in the budget,
+    // otherwise read them from the database again.
+    bool in_memory = num_particles*ParticleChunk::bytes_per_particle
+                        <= options.get_memory_budget()*1048576.0;
+    std::vector<ParticleChunk> chunks;
+
+    // Temperatures do not apply in ABC mode. The first one is used for
+    // posterior.db and the posterior samples.
+    std::vector<double> temperatures{1.0};
+    if(!options.get_abc())
+        temperatures = options.get_temperatures();
+    int num_temperatures = int(temperatures.size());
+    std::vector<double> inverse_temperatures(num_temperatures);
+    for(int i=0; i<num_temperatures; ++i)
+        inverse_temperatures[i] = 1.0/temperatures[i];
+
+    // Fill in logm, logx and (for ABC) the replacement log likelihood of a
+    // chunk. Temperatures are applied later, so this is done only once.
+    auto finish = [&](ParticleChunk& chunk)
+    {
+        int n = chunk.size();
+        chunk.logms.resize(n);
+        chunk.logxs.resize(n);
+        pool.parallel_for(n, [&](int, long long begin, long long end)
+        {
+            for(long long k=begin; k<end; ++k)
+            {
+                int level = chunk.levels[k];
+                chunk.logms[k] = particle_logms[level];
+                chunk.logxs[k] = level_logxs[level]
+                                    + log1p(-level_cs[level]*(chunk.ranks[k] + 0.5));
+            }
+
+            // For ABC, replace log likelihoods
+            if(options.get_abc())
             {
-                rank = 0;
-                old_level = level;
+                double cut = options.get_abc_fraction()*num_particles;
+                for(long long k=begin; k<end; ++k)
+                {
+                    if(chunk.start + k < cut)
+                        chunk.logls[k] = minus_infinity;
+                    else
+                        chunk.logls[k] = -chunk.logms[k];
+                }
             }
+        });
+    };
+
+    // Stream the particles in (logl, tb) order, a chunk at a time, and pass
+    // each chunk to f. Level pairs increase with level ID, so this also
+    // orders by level. SQLite answers it from scanned_logl_tb_idx.
+    auto scan = [&](auto&& f)
+    {
+        if(in_memory && chunks.size() > 0)
+        {
+            for(const auto& chunk: chunks)
+                f(chunk);
+            return;
+        }
+
+        ParticleChunk chunk;
+        chunk.start = 0;
+        auto flush = [&]()
+        {
+            finish(chunk);
+            f(chunk);
+            long long next = chunk.start + chunk.size();
+            if(in_memory)
+                chunks.emplace_back(std::move(chunk));
+            chunk = ParticleChunk();
+            chunk.start = next;
+        };
 
-            particle_ids.push_back(particle_id);
-            logms.emplace_back(level_logms[level]
-                                    - log(level_num_particles[level]));
-            logls.push_back(logl / options.get_temperature());
+        int rank = 0;
+        int old_level = 0;
+        db << "SELECT id, level, logl, full FROM scanned ORDER BY logl, tb;" >>
+            [&](int particle_id, int level, double logl, bool full)
+            {
+                if(level != old_level)
+                {
+                    rank = 0;
+                    old_level = level;
+                }
 
-            // X_particle = X_level - (rank+0.5)*N_level * M_level
-            double logx = logdiffexp(level_logxs[level],
-                                     log((rank + 0.5)/level_num_particles[level])
-                                         + level_logms[level]);
-            logxs.emplace_back(logx);
-            is_full.push_back(full);
-            ++rank;
+                if(chunk.size() == 0)
+                {
+                    chunk.ids.reserve(ParticleChunk::capacity);
+                    chunk.levels.reserve(ParticleChunk::capacity);
+                    chunk.ranks.reserve(ParticleChunk::capacity);
+                    chunk.logls.reserve(ParticleChunk::capacity);
+                    chunk.full.reserve(ParticleChunk::capacity);
+                }
+                chunk.ids.push_back(particle_id);
+                chunk.levels.push_back(level);
+                chunk.ranks.push_back(rank++);
+                chunk.logls.push_back(logl);
+                chunk.full.push_back(full);
 
-            db << "INSERT INTO particles (id, logx, logm) VALUES (?, ?, ?);"
-               << particle_id << logx << logms.back();
+                if(chunk.size() == ParticleChunk::capacity)
+                    flush();
+            };
+        if(chunk.size() > 0)
+            flush();
+    };
 
-            if(int(logxs.size()) == max_particle_id ||
-                int(logxs.size()) % 1000 == 0)
+    // First pass: prior times likelihood, information, and the entropy of
+    // the normalised weights of the full particles, at every temperature.
+    // Each thread accumulates its own share and they are merged at the end.
+    std::vector<std::vector<LogSumExp>>
+                evidences(pool.size(), std::vector<LogSumExp>(num_temperatures)),
+                full_evidences = evidences;
+    long long processed = 0;
+    scan([&](const ParticleChunk& chunk)
+    {
+        pool.parallel_for(chunk.size(),
+                          [&](int thread, long long begin, long long end)
+        {
+            for(int i=0; i<num_temperatures; ++i)
             {
-                std::cout << "\rProcessed " << logxs.size() << " particles.";
-                std::cout << std::flush;
+                LogSumExp evidence, full_evidence;
+                for(long long k=begin; k<end; ++k)
+                {
+                    double logl = chunk.logls[k]*inverse_temperatures[i];
+                    double logh = chunk.logms[k] + logl;
+                    evidence.add(logh, logl);
+                    if(chunk.full[k])
+                        full_evidence.add(logh, logh);
+                }
+                evidences[thread][i].merge(evidence);
+                full_evidences[thread][i].merge(full_evidence);
             }
-        };
+        });
+
+        processed += chunk.size();
+        std::cout << "\rProcessed " << processed << " particles.";
+        std::cout << std::flush;
+    });
     std::cout << '\n' << std::endl;
 
     std::cout << "Computing results..." << std::flush;
-
-    // For ABC, replace log likelihoods
-    if(options.get_abc())
+    std::vector<double> logzs(num_temperatures), Hs(num_temperatures),
+                        full_logzs(num_temperatures);
+    std::vector<int> esses(num_temperatures);
+    for(int i=0; i<num_temperatures; ++i)
     {
-        for(size_t i=0; i<logls.size(); ++i)
+        for(int j=1; j<pool.size(); ++j)
         {
-            if(i < options.get_abc_fraction()*logls.size())
-                logls[i] = minus_infinity;
-            else
-                logls[i] = -logms[i];
+            evidences[0][i].merge(evidences[j][i]);
+            full_evidences[0][i].merge(full_evidences[j][i]);
         }
+        logzs[i] = evidences[0][i].get_log_total();
+        Hs[i] = evidences[0][i].get_mean() - logzs[i];
+        full_logzs[i] = full_evidences[0][i].get_log_total();
+        esses[i] = int(exp(full_logzs[i] - full_evidences[0][i].get_mean())) + 1;
     }
+    double logz = logzs[0];
+    double full_logz = full_logzs[0];
+    int num_samples = esses[0];
 
-    // Prior times likelihood, posterior, information, etc
-    std::vector<double> loghs(logms.size()), logps(logms.size());
-    for(int i=0; i<int(logms.size()); ++i)
-        loghs[i] = logms[i] + logls[i];
-    double logz = logsumexp(loghs);
-    for(int i=0; i<int(logms.size()); ++i)
+    // Positions of the posterior samples in the cumulative distribution of
+    // the full particles
+    RNG rng; rng.set_seed(0);
+    std::vector<double> us(num_samples);
+    for(double& u: us)
+        u = rng.rand();
+    std::sort(us.begin(), us.end());
+
+    // Second pass: write posterior.db in one transaction with a single
+    // prepared statement, and pick out the posterior samples.
+    std::vector<int> sample_ids;
+    sample_ids.reserve(num_samples);
+    double cumulative = 0.0;
+    int last_full_id = 0;
+    db << "BEGIN;";
+    db << "DELETE FROM particles;";
+    auto insert_particle = db << "INSERT INTO particles (id, logx, logm, logp)\
+                                  VALUES (?, ?, ?, ?);";
+    scan([&](const ParticleChunk& chunk)
     {
-        logps[i] = loghs[i] - logz;
-        db << "UPDATE particles SET logp = ? WHERE id = ?;"
-           << logps[i] << particle_ids[i];
-    }
-    double H = 0.0;
-    for(int i=0; i<int(loghs.size()); ++i)
+        for(int k=0; k<chunk.size(); ++k)
+        {
+            double logh = chunk.logms[k]
+                                + chunk.logls[k]*inverse_temperatures[0];
+            insert_particle << chunk.ids[k] << chunk.logxs[k]
+                            << chunk.logms[k] << logh - logz;
+            insert_particle++;
+
+            if(chunk.full[k])
+            {
+                cumulative += exp(logh - full_logz);
+                while(int(sample_ids.size()) < num_samples
+                            && us[sample_ids.size()] < cumulative)
+                    sample_ids.push_back(chunk.ids[k]);
+                last_full_id = chunk.ids[k];
+            }
+        }
+    });
+    insert_particle.used(true);
+    for(int i=0; i<num_temperatures; ++i)
     {
-        double p = exp(logps[i]);
-        if(p > 0.0)
-            H +=  p*(logps[i] - logms[i]);
+        db << "INSERT OR REPLACE INTO temperatures VALUES (?, ?, ?, ?);"
+           << temperatures[i] << logzs[i] << Hs[i] << esses[i];
     }
+    db << "COMMIT;";
 
-    // Log-probs of full particles
-    std::vector<double> full_logps;
-    std::vector<int> full_pids;
-    for(int i=0; i<int(loghs.size()); ++i)
+    // Any left over because of roundoff in the cumulative sum
+    while(int(sample_ids.size()) < num_samples)
+        sample_ids.push_back(last_full_id);
+
+    // Uncertainty, at the first temperature. Each replicate draws the level
+    // compressions from Beta distributions based on the exceeds/visits
+    // counts (with the same prior as Levels::revise), and the masses of the
+    // particles within each level from a flat Dirichlet distribution, i.e.,
+    // random positions instead of (rank + 0.5)/N.
+    int num_replicates = options.get_num_replicates();
+    std::vector<double> replicate_logzs(num_replicates),
+                        replicate_Hs(num_replicates);
+    if(num_replicates > 0)
     {
-        if(is_full[i])
+        std::vector<RNG> replicate_rngs(num_replicates);
+        std::vector<std::vector<double>>
+                replicate_logms(num_replicates, std::vector<double>(num_levels));
+        pool.parallel_for(num_replicates,
+                          [&](int, long long begin, long long end)
+        {
+            std::vector<double> logxs(num_levels, 0.0);
+            for(long long r=begin; r<end; ++r)
+            {
+                auto& rng = replicate_rngs[r];
+                rng.set_seed(r + 1);
+                for(int j=1; j<num_levels; ++j)
+                {
+                    double e = level_exceeds[j-1];
+                    double v = level_visits[j-1];
+                    logxs[j] = logxs[j-1]
+                                + log(rand_beta(rng, e + 100.0*exp(-1.0),
+                                                v - e + 100.0*(1.0 - exp(-1.0))));
+                }
+                for(int j=0; j<num_levels-1; ++j)
+                    replicate_logms[r][j] = logdiffexp(logxs[j], logxs[j+1]);
+                replicate_logms[r][num_levels-1] = logxs.back();
+            }
+        });
+
+        // Within each level, sum exponential weights (whose normalised
+        // values are the Dirichlet draws) times the likelihoods.
+        std::vector<std::vector<LogSumExp>>
+                level_evidences(num_replicates, std::vector<LogSumExp>(num_levels));
+        std::vector<std::vector<double>>
+                level_weights(num_replicates, std::vector<double>(num_levels, 0.0));
+        scan([&](const ParticleChunk& chunk)
+        {
+            pool.parallel_for(num_replicates,
+                              [&](int, long long begin, long long end)
+            {
+                for(long long r=begin; r<end; ++r)
+                {
+                    auto& rng = replicate_rngs[r];
+                    auto& evidences = level_evidences[r];
+                    auto& weights = level_weights[r];
+                    for(int k=0; k<chunk.size(); ++k)
+                    {
+                        double logl = chunk.logls[k]*inverse_temperatures[0];
+                        double w = -log(1.0 - rng.rand());
+                        evidences[chunk.levels[k]].add(log(w) + logl, logl);
+                        weights[chunk.levels[k]] += w;
+                    }
+                }
+            });
+        });
+
+        for(int r=0; r<num_replicates; ++r)
         {
-            full_logps.push_back(logps[i]);
-            full_pids.push_back(particle_ids[i]);
+            LogSumExp evidence;
+            for(int j=0; j<num_levels; ++j)
+            {
+                if(level_weights[r][j] <= 0.0)
+                    continue;
+                evidence.add(replicate_logms[r][j]
+                                + level_evidences[r][j].get_log_total()
+                                - log(level_weights[r][j]),
+                             level_evidences[r][j].get_mean());
+            }
+            replicate_logzs[r] = evidence.get_log_total();
+            replicate_Hs[r] = evidence.get_mean() - replicate_logzs[r];
         }
+
+        db << "BEGIN;";
+        for(int r=0; r<num_replicates; ++r)
+        {
+            db << "INSERT INTO replicates VALUES (?, ?, ?);"
+               << r + 1 << replicate_logzs[r] << replicate_Hs[r];
+        }
+        db << "COMMIT;";
     }
-    double tot = logsumexp(full_logps);
-    double ess = 0.0;
-    for(double& lp: full_logps)
-    {
-        lp -= tot;
-        double p = exp(lp);
-        if(p > 0.0)
-            ess += -p*lp;
-    }
-    ess = exp(ess);
-    double max_logp_full = *max_element(full_logps.begin(), full_logps.end());
+
     std::cout << "done.\n" << std::endl;
     std::cout << "--------------------------------" << std::endl;
 
@@ -183,9 +582,60 @@ inline void postprocess(const CommandLineOptions& options)
     sout << "# Natural log of the marginal likelihood\n";
     sout << "logz: " << logz << "\n\n";
     sout << "# Prior-to-posterior Kullback-Leibler divergence, in nats\n";
-    sout << "info: " << H << "\n\n";
+    sout << "info: " << Hs[0] << "\n\n";
     sout << "# Effective posterior sample size (full particles)\n";
-    sout << "ess: " << int(ess) + 1 << std::endl;
+    sout << "ess: " << num_samples << std::endl;
+    if(likelihood_calls > 0.0)
+    {
+        sout << "\n# Effective samples per likelihood evaluation\n";
+        sout << "ess_per_likelihood_call: " << num_samples/likelihood_calls;
+        sout << std::endl;
+    }
+    if(num_replicates > 0)
+    {
+        // Standard deviation and quantiles over the replicates
+        double mean = 0.0, sd = 0.0;
+        for(double logz_r: replicate_logzs)
+            mean += logz_r/num_replicates;
+        for(double logz_r: replicate_logzs)
+            sd += pow(logz_r - mean, 2)/num_replicates;
+        sd = sqrt(sd);
+
+        auto quantiles = [&](std::vector<double> xs)
+        {
+            std::sort(xs.begin(), xs.end());
+            std::stringstream ss;
+            ss << std::setprecision(Options::stdout_precision) << '{';
+            std::vector<double> qs{0.025, 0.16, 0.5, 0.84, 0.975};
+            for(size_t i=0; i<qs.size(); ++i)
+            {
+                ss << qs[i] << ": " << xs[int(qs[i]*(xs.size() - 1) + 0.5)];
+                if(i < qs.size() - 1)
+                    ss << ", ";
+            }
+            ss << '}';
+            return ss.str();
+        };
+
+        sout << "\n# Uncertainty from " << num_replicates << " replicates";
+        sout << " with randomised log-X values\n";
+        sout << "logz_sd: " << sd << "\n";
+        sout << "logz_quantiles: " << quantiles(replicate_logzs) << "\n";
+        sout << "info_quantiles: " << quantiles(replicate_Hs) << std::endl;
+    }
+    if(num_temperatures > 1)
+    {
+        sout << "\n# The same, at each temperature (the first is above)\n";
+        sout << "temperatures:\n";
+        for(int i=0; i<num_temperatures; ++i)
+        {
+            sout << "  - temperature: " << temperatures[i] << '\n';
+            sout << "    logz: " << logzs[i] << '\n';
+            sout << "    info: " << Hs[i] << '\n';
+            sout << "    ess: " << esses[i] << '\n';
+        }
+        sout << std::flush;
+    }
 
     std::fstream fout("output/results.yaml", std::ios::out);
     fout << sout.str();
@@ -194,28 +644,18 @@ inline void postprocess(const CommandLineOptions& options)
     // And to stdout
     std::cout << sout.str() << std::endl;
 
-    // Get posterior samples and output as CSV
-    RNG rng; rng.set_seed(0);
-    int count = 0;
+    // Output posterior samples as CSV, in random order
+    for(int i=num_samples-1; i>0; --i)
+        std::swap(sample_ids[i], sample_ids[rng.rand_int(i+1)]);
     fout.open("output/posterior.csv", std::ios::out);
     fout << std::setprecision(Options::stdout_precision);
     fout << T::parameter_names.csv_header() << std::endl;
-    T t(rng);
-    db << "BEGIN;";
-    while(count < int(ess) + 1)
+    for(int id: sample_ids)
     {
-        int k = rng.rand_int(full_pids.size());
-        if(rng.rand() <= exp(full_logps[k] - max_logp_full))
-        {
-            std::string s;
-            reader << "SELECT params FROM particles WHERE id = ?;"
-                   << full_pids[k] >> s;
-            fout << s << std::endl;
-            ++count;
-        }
-    };
-    db << "COMMIT;";
-    reader << "COMMIT;";
+        std::vector<char> params;
+        reader << "SELECT params FROM particles WHERE id = ?;" << id >> params;
+        fout << Compression::decode(params) << std::endl;
+    }
 }
 
 } // namespace
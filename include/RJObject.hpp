@@ -0,0 +1,355 @@
+#ifndef DNest5_RJObject_hpp
+#define DNest5_RJObject_hpp
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <iomanip>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <Tools/Misc.hpp>
+#include <Tools/RNG.hpp>
+#include <vector>
+#include "Options.h"
+
+namespace DNest5
+{
+
+/*
+    What RJObject needs from the conditional prior of its components.
+    The prior owns any hyperparameters and maps a component's Uniform(0, 1)
+    coordinates to its actual parameters.
+
+        P(rng)              Generate hyperparameters from their prior
+        perturb(rng)        Metropolis proposal for the hyperparameters,
+                            returning the log of the Hastings factor
+        from_uniform(us)    Component parameters given Uniform(0, 1) ones
+        to_string()         CSV values of the hyperparameters
+        names               constexpr names of the hyperparameters
+        component_names     constexpr names of a component's dim parameters
+*/
+template<typename P, int dim>
+concept ConditionalPrior = std::copyable<P>
+                && requires(P p, const P& cp, Tools::RNG& rng,
+                            const std::array<double, dim>& us)
+{
+    P(rng);
+    { p.perturb(rng) } -> std::convertible_to<double>;
+    { cp.from_uniform(us) } -> std::same_as<std::array<double, dim>>;
+    { cp.to_string() } -> std::convertible_to<std::string>;
+    std::size(P::names);
+    requires std::size(P::component_names) == dim;
+};
+
+/*
+    A variable number (0 to max_num_components) of components, each with dim
+    parameters, for mixture and source-finding models. The number of
+    components has a uniform prior and the components are iid given the
+    hyperparameters in P.
+
+    Components live in a fixed-size pool inside the object, the first size()
+    slots in use, so perturbing or copying one never allocates and copying
+    only touches the components in use.
+
+    After perturb(), get_added() and get_removed() list the components that
+    appeared and disappeared (a moved component is removed at its old
+    position and added at its new one), so the owner can update its
+    likelihood incrementally. When too much changed for that, e.g. after a
+    hyperparameter move, everything_changed() is true instead.
+*/
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+class RJObject
+{
+    public:
+        using Component = std::array<double, dim>;
+
+    private:
+
+        // Hyperparameters and the conditional prior
+        P prior;
+
+        // The pool. us holds Uniform(0, 1) coordinates, xs the parameters.
+        int num_components;
+        std::array<Component, max_num_components> us;
+        std::array<Component, max_num_components> xs;
+
+        // Changes made by the last perturb()
+        static constexpr int max_changes = 16;
+        bool all_changed;
+        int num_added, num_removed;
+        std::array<Component, max_changes> added;
+        std::array<Component, max_changes> removed;
+
+        void clear_changes();
+        void note(const Component& x, bool is_addition);
+
+        // The three kinds of proposal
+        double perturb_num_components(Tools::RNG& rng);
+        double perturb_components(Tools::RNG& rng);
+        double perturb_hyperparameters(Tools::RNG& rng);
+
+        void add_component(const Component& u);
+        void remove_component(int k);
+
+    public:
+
+        // Generate from the prior
+        inline RJObject(Tools::RNG& rng);
+
+        inline RJObject(const RJObject& other);
+        inline RJObject& operator = (const RJObject& other);
+
+        // Metropolis proposal, returning the log of the Hastings factor
+        inline double perturb(Tools::RNG& rng);
+
+        // Current state
+        int size() const { return num_components; }
+        std::span<const Component> components() const
+        { return std::span<const Component>(xs.data(), num_components); }
+        const P& get_prior() const { return prior; }
+
+        // What the last perturb() changed
+        bool everything_changed() const { return all_changed; }
+        std::span<const Component> get_added() const
+        { return std::span<const Component>(added.data(), num_added); }
+        std::span<const Component> get_removed() const
+        { return std::span<const Component>(removed.data(), num_removed); }
+
+        // CSV values: hyperparameters, size(), then each component
+        // parameter over all max_num_components slots, padded with zeros
+        inline std::string to_string() const;
+
+        // Column names matching to_string()
+        static std::vector<std::string> names();
+};
+
+/* Implementations follow */
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline RJObject<P, dim, max_num_components>::RJObject(Tools::RNG& rng)
+:prior(rng)
+,num_components(0)
+{
+    clear_changes();
+    int n = rng.rand_int(max_num_components + 1);
+    for(int k=0; k<n; ++k)
+    {
+        Component u;
+        for(double& ui: u)
+            ui = rng.rand();
+        add_component(u);
+    }
+    clear_changes();
+    all_changed = true;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline RJObject<P, dim, max_num_components>::RJObject(const RJObject& other)
+:prior(other.prior)
+{
+    *this = other;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline RJObject<P, dim, max_num_components>&
+RJObject<P, dim, max_num_components>::operator = (const RJObject& other)
+{
+    if(this == &other)
+        return *this;
+
+    // Copy only what is in use
+    prior = other.prior;
+    num_components = other.num_components;
+    std::copy_n(other.us.begin(), num_components, us.begin());
+    std::copy_n(other.xs.begin(), num_components, xs.begin());
+    all_changed = other.all_changed;
+    num_added = other.num_added;
+    num_removed = other.num_removed;
+    std::copy_n(other.added.begin(), num_added, added.begin());
+    std::copy_n(other.removed.begin(), num_removed, removed.begin());
+    return *this;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline void RJObject<P, dim, max_num_components>::clear_changes()
+{
+    all_changed = false;
+    num_added = 0;
+    num_removed = 0;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline void RJObject<P, dim, max_num_components>::note(const Component& x,
+                                                       bool is_addition)
+{
+    if(all_changed)
+        return;
+    int& n = is_addition ? num_added : num_removed;
+    if(n == max_changes)
+    {
+        all_changed = true;
+        return;
+    }
+    (is_addition ? added : removed)[n++] = x;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline void RJObject<P, dim, max_num_components>::add_component(const Component& u)
+{
+    us[num_components] = u;
+    xs[num_components] = prior.from_uniform(u);
+    note(xs[num_components], true);
+    ++num_components;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline void RJObject<P, dim, max_num_components>::remove_component(int k)
+{
+    // Fill the gap with the last component
+    note(xs[k], false);
+    --num_components;
+    us[k] = us[num_components];
+    xs[k] = xs[num_components];
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline double RJObject<P, dim, max_num_components>::perturb(Tools::RNG& rng)
+{
+    clear_changes();
+
+    constexpr bool has_hyperparameters = std::size(P::names) > 0;
+    int which = rng.rand_int(has_hyperparameters ? 3 : 2);
+    if(which == 0)
+        return perturb_num_components(rng);
+    else if(which == 1)
+    {
+        // Nothing to move. Switching to a birth instead would make births
+        // from zero likelier than deaths to it, unbalancing the chain.
+        if(num_components == 0)
+            return Tools::minus_infinity;
+        return perturb_components(rng);
+    }
+    return perturb_hyperparameters(rng);
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline double
+RJObject<P, dim, max_num_components>::perturb_num_components(Tools::RNG& rng)
+{
+    // Births come from the conditional prior and deaths are uniformly
+    // chosen, so with a uniform prior on the number the Hastings factor is 1
+    int delta = 1;
+    if(rng.rand() <= 0.5)
+        delta = int(pow(max_num_components, rng.rand()));
+
+    if(rng.rand() <= 0.5)
+    {
+        if(num_components + delta > max_num_components)
+            return Tools::minus_infinity;
+        for(int i=0; i<delta; ++i)
+        {
+            Component u;
+            for(double& ui: u)
+                ui = rng.rand();
+            add_component(u);
+        }
+    }
+    else
+    {
+        if(num_components - delta < 0)
+            return Tools::minus_infinity;
+        for(int i=0; i<delta; ++i)
+            remove_component(rng.rand_int(num_components));
+    }
+
+    return 0.0;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline double
+RJObject<P, dim, max_num_components>::perturb_components(Tools::RNG& rng)
+{
+    int num = 1;
+    if(rng.rand() <= 0.5)
+        num = int(pow(num_components, rng.rand()));
+
+    for(int i=0; i<num; ++i)
+    {
+        int k = rng.rand_int(num_components);
+        int j = rng.rand_int(dim);
+        note(xs[k], false);
+        us[k][j] += rng.randh();
+        Tools::wrap(us[k][j]);
+        xs[k] = prior.from_uniform(us[k]);
+        note(xs[k], true);
+    }
+
+    return 0.0;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline double
+RJObject<P, dim, max_num_components>::perturb_hyperparameters(Tools::RNG& rng)
+{
+    // Components keep their Uniform(0, 1) coordinates and move with the
+    // conditional prior
+    double logh = prior.perturb(rng);
+    for(int k=0; k<num_components; ++k)
+        xs[k] = prior.from_uniform(us[k]);
+    all_changed = true;
+    return logh;
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+inline std::string RJObject<P, dim, max_num_components>::to_string() const
+{
+    std::stringstream ss;
+    ss << std::setprecision(Options::stdout_precision);
+    std::string hyperparameters = prior.to_string();
+    if(!hyperparameters.empty())
+        ss << hyperparameters << ',';
+    ss << num_components;
+    for(int j=0; j<dim; ++j)
+        for(int k=0; k<max_num_components; ++k)
+            ss << ',' << (k < num_components ? xs[k][j] : 0.0);
+    return ss.str();
+}
+
+template<typename P, int dim, int max_num_components>
+requires ConditionalPrior<P, dim>
+std::vector<std::string> RJObject<P, dim, max_num_components>::names()
+{
+    std::vector<std::string> result(std::begin(P::names), std::end(P::names));
+    result.emplace_back("num_components");
+    for(int j=0; j<dim; ++j)
+    {
+        for(int k=0; k<max_num_components; ++k)
+        {
+            std::stringstream ss;
+            ss << P::component_names[j] << '[' << k << ']';
+            result.emplace_back(ss.str());
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+#endif
+
@@ -1,13 +1,24 @@
 #ifndef DNest5_Sampler_hpp
 #define DNest5_Sampler_hpp
 
+#include "Compression.h"
 #include "Database.h"
 #include "Levels.h"
+#include "LikelihoodCache.h"
+#include "Logger.h"
+#include "Model.h"
 #include "Options.h"
 #include "Particle.h"
+#include "Status.h"
+#include "ThreadPool.h"
+#include "Timings.h"
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <sstream>
 #include <thread>
 #include <Tools/Barrier.hpp>
 #include <Tools/RNG.hpp>
@@ -23,11 +34,19 @@ using Tools::Barrier, Tools::RNG, Tools::wrap;
 template<typename T>
 class Sampler
 {
+    static_assert(Model<T>, "T does not provide what Sampler needs.");
+    static_assert(!(ExitsEarly<T> && UsesThreadPool<T>),
+                  "T's log_likelihood() can take a threshold or the pool, \
+not both.");
+
     private:
 
         // Unique sampler ID
         int sampler_id;
 
+        // A set of options
+        Options options;
+
         // A database connection for I/O
         Database database;
 
@@ -35,9 +54,8 @@ class Sampler
         std::optional<sqlite::database_binder> save_particle_ps;
         std::optional<sqlite::database_binder> save_level_ps;
 
-
-        // A set of options
-        Options options;
+        // Applied to saved params
+        Compression compression;
 
         // The random number generators
         std::vector<RNG> rngs;
@@ -51,16 +69,57 @@ class Sampler
         // Copies of levels, for multithreading
         std::vector<Levels> levels_copies;
 
-        // Count work
+        // Count work, and likelihood evaluations by each thread (padded so
+        // that the threads' counters don't share a cache line)
         unsigned long long work;
+        struct alignas(64) Counter { unsigned long long value = 0; };
+        std::vector<Counter> likelihood_calls;
         unsigned long long saved_particles, saved_full_particles;
         bool done;
 
         // A barrier
         std::unique_ptr<Barrier> barrier;
 
-        // Do a Metropolis step of particle k, or of its level
-        inline bool metropolis_step(int k, int thread);
+        // Each thread's scratch space for a batch of Metropolis steps,
+        // reused from one batch to the next
+        struct Batch
+        {
+            std::vector<int> order, swaps;
+            std::vector<Particle<T>> proposals;
+            std::vector<char> level_first, passed, exited;
+
+            // Steps each particle has left, where its proposals start in
+            // proposals, and whether its next step's level move (going
+            // first) is already done
+            std::vector<int> remaining, first;
+            std::vector<char> level_moved;
+            std::vector<std::uint64_t> keys;
+            std::vector<const T*> models;
+            std::vector<double> thresholds, logls;
+        };
+        std::vector<Batch> batches;
+
+        // Each thread's recently computed log likelihoods, if T has hash()
+        std::vector<LikelihoodCache> caches;
+
+        // Helper threads shared by all threads' likelihood evaluations,
+        // and by models that split up their own work
+        std::unique_ptr<ThreadPool> pool;
+
+        // Log likelihood of t, or nullopt if T stopped early because it
+        // is below threshold. Gives T the pool if it takes one.
+        inline std::optional<double> log_likelihood(const T& t,
+                                                    double threshold);
+
+        // Do num_tries Metropolis steps of each of the (distinct) particles
+        // ks, evaluating the proposals' likelihoods together, and add them
+        // to the stash. Returns the number of steps. Or do a step of a level.
+        inline int metropolis_steps(std::span<const int> ks, int thread);
+
+        // Its three phases
+        inline void make_proposals(std::span<const int> ks, int thread);
+        inline void evaluate_proposals(int thread);
+        inline int accept_proposals(std::span<const int> ks, int thread);
         inline void metropolis_step_level(int k, int thread);
 
         // Save levels or particles
@@ -77,11 +136,48 @@ class Sampler
         inline void prune_laggards();
         int pruned;
 
+        // The progress message of the current round, if it is being logged
+        bool log_round;
+        std::string round_message;
+        LogFields round_fields;
+        inline void start_round_message();
+        inline void finish_round_message();
+
+        // When run() started, and seconds from then to the latest level
+        std::chrono::steady_clock::time_point start_time;
+        double level_seconds;
+
+        // When exploring started, and when each thread finished. Thread 0
+        // works out how long they waited at the barrier, as they can't
+        // write it after leaving.
+        std::chrono::steady_clock::time_point explore_time;
+        struct alignas(64) Arrival { std::chrono::steady_clock::time_point time; };
+        std::vector<Arrival> arrivals;
+
+        // Live metrics, and thread seconds spent exploring and waiting and
+        // the work done as of the last update
+        Status status;
+        double explore_seconds, wait_seconds;
+        unsigned long long status_work;
+        inline void write_status(bool finished);
+
+#ifdef DNest5_TIMINGS
+        // Time spent in each phase by each thread, and as of the last save
+        std::vector<PhaseTimes> timings, saved_timings;
+        inline void save_timings();
+#endif
+
     public:
 
         // Construct with a set of options.
         inline Sampler(Options _options = Options());
         inline void run();
+
+        // Totals so far, for benchmarks
+        unsigned long long get_work() const { return work; }
+        inline unsigned long long get_likelihood_calls() const;
+        int get_num_levels() const { return levels.get_num_levels(); }
+        double get_level_seconds() const { return level_seconds; }
 };
 
 /* IMPLEMENTATIONS FOLLOW */
@@ -89,13 +185,30 @@ class Sampler
 template<typename T>
 inline Sampler<T>::Sampler(Options _options)
 :options(std::move(_options))
+,database("output/dnest5.db", options.snapshot_interval, options.max_data_loss)
+,compression(options.compression)
 ,levels(options)
 ,levels_copies(options.num_threads, options)
 ,work(0)
+,likelihood_calls(options.num_threads)
 ,saved_particles(0)
 ,saved_full_particles(0)
 ,done(false)
+,batches(options.num_threads)
+,caches(options.num_threads,
+        LikelihoodCache(HashesState<T> ? options.likelihood_cache_size : 0))
 ,pruned(0)
+,log_round(false)
+,level_seconds(0.0)
+,arrivals(options.num_threads)
+,status("output/status.json", options.status_interval)
+,explore_seconds(0.0)
+,wait_seconds(0.0)
+,status_work(0)
+#ifdef DNest5_TIMINGS
+,timings(options.num_threads)
+,saved_timings(options.num_threads)
+#endif
 {
     // Shorthand to database connection
     auto& db = database.db;
@@ -105,28 +218,32 @@ inline Sampler<T>::Sampler(Options _options)
     save_particle_ps.emplace(database.db << "INSERT INTO particles (sampler, level, params, logl, tb)\
                VALUES (?, ?, ?, ?, ?);");
     save_level_ps.emplace(database.db << "INSERT INTO levels\
-               (id, logx, logl, tb, exceeds, visits, accepts, tries)\
-               VALUES (?, ?, ?, ?, ?, ?, ?, ?)\
+               (id, logx, logl, tb, exceeds, visits, accepts, tries,\
+                log_scale, evaluations, early_exits)\
+               VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)\
                ON CONFLICT (id) DO UPDATE\
-               SET (logx, exceeds, visits, accepts, tries) = \
+               SET (logx, exceeds, visits, accepts, tries, log_scale,\
+                    evaluations, early_exits) = \
                (excluded.logx, excluded.exceeds, excluded.visits, \
-                excluded.accepts, excluded.tries);");
+                excluded.accepts, excluded.tries, excluded.log_scale, \
+                excluded.evaluations, excluded.early_exits);");
 
     db << "BEGIN;";
 
     // Initialise the sampler, first by setting a sampler ID.
-    std::cout << "Initialising sampler:" << std::endl;
     sampler_id = 1;
     db << "SELECT MAX(id) FROM samplers;" >>
         [&](int max_id)
         {
             sampler_id = max_id + 1;
         };
-    std::cout << "    Sampler ID = " << sampler_id << "." << std::endl;
+    auto message = Logger::stream();
+    message << "Initialising sampler:\n";
+    message << "    Sampler ID = " << sampler_id << ".\n";
 
     // Save sampler info to the database
     db << "INSERT INTO samplers\
-            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);"
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, 0);"
        << sampler_id << options.num_particles << options.num_threads
        << options.new_level_interval << options.save_interval
        << options.thin << options.max_num_levels
@@ -137,7 +254,7 @@ inline Sampler<T>::Sampler(Options _options)
     rngs.reserve(options.num_threads);
     int count;
     int seed = options.rng_seed;
-    std::cout << "    RNG seeds = (";
+    std::string seeds;
     do
     {
         db << "SELECT COUNT(*) FROM rngs WHERE seed = ?;"
@@ -147,22 +264,30 @@ inline Sampler<T>::Sampler(Options _options)
             rngs.emplace_back(RNG());
             rngs.back().set_seed(seed);
             db << "INSERT INTO rngs VALUES (?, ?);" << seed << sampler_id;
-            std::cout << seed;
-            if(int(rngs.size()) < options.num_threads-1)
-                std::cout << ", ";
-            else
-                std::cout << ")." << std::endl;
+            seeds += (seeds.empty()?"":", ") + std::to_string(seed);
             seed -= Options::rng_seed_gap;
         }
     }while(int(rngs.size()) < options.num_threads);
+    message << "    RNG seeds = (" << seeds << ").";
+    log_event(LogLevel::info, "sampler", message.str(),
+              {{"sampler_id", sampler_id}, {"rng_seeds", seeds}});
 
     // Save level info to the database
     save_levels();
 
+    // Load the data, if any
+    if constexpr(LoadsData<T>)
+        T::load_data();
+
     // Generate initial particles
-    std::cout << "    Generating " << options.num_particles << " particles ";
-    std::cout << "from the prior..." << std::flush;
+    log_event(LogLevel::info, "generating",
+              "    Generating " + std::to_string(options.num_particles)
+              + " particles from the prior.\n",
+              {{"num_particles", options.num_particles}});
     particles.reserve(options.num_particles);
+    int helpers = std::max(0, int(std::thread::hardware_concurrency())
+                                                    - options.num_threads);
+    pool = std::make_unique<ThreadPool>(options.helper_threads.value_or(helpers));
     auto& rng = rngs[0];
     // Always generate from the prior serially - so classes can assume that
     // e.g., static data can be loaded in a constructor
@@ -170,11 +295,11 @@ inline Sampler<T>::Sampler(Options _options)
     {
         int level = 0;
         T t(rng);
-        double logl = t.log_likelihood();
+        double logl = *log_likelihood(t, minus_infinity);
+        ++likelihood_calls[0].value;
         double tb = rng.rand();
         particles.emplace_back(std::move(t), logl, tb, level);
     }
-    std::cout << "done.\n" << std::endl;
 
     db << "COMMIT;";
 }
@@ -182,6 +307,8 @@ inline Sampler<T>::Sampler(Options _options)
 template<typename T>
 inline void Sampler<T>::run()
 {
+    start_time = std::chrono::steady_clock::now();
+
     // Create the barrier
     barrier.reset(new Barrier(options.num_threads));
 
@@ -201,6 +328,107 @@ inline void Sampler<T>::run()
     database.db << "BEGIN;";
     save_levels();
     database.db << "COMMIT;";
+
+    // Final flush of an in-memory database
+    database.snapshot();
+    write_status(true);
+
+    if(compression.enabled())
+        log_event(LogLevel::info, "compression", compression.report());
+    if(caches[0].enabled())
+        log_event(LogLevel::info, "likelihood_cache",
+                  LikelihoodCache::report(caches));
+#ifdef DNest5_TIMINGS
+    log_event(LogLevel::info, "timings", PhaseTimes::report(timings));
+#endif
+    Logger::get().flush();
+}
+
+template<typename T>
+inline void Sampler<T>::write_status(bool finished)
+{
+    // Only thread 0 calls this, while the others wait or have finished
+    double seconds = status.seconds_since_write();
+    double elapsed = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_time).count();
+    auto num = Status::number;
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "  \"sampler_id\": " << sampler_id << ",\n";
+    ss << "  \"finished\": " << (finished?"true":"false") << ",\n";
+    ss << "  \"elapsed_seconds\": " << num(elapsed) << ",\n";
+    ss << "  \"saved_particles\": " << saved_particles << ",\n";
+    ss << "  \"saved_full_particles\": " << saved_full_particles << ",\n";
+    ss << "  \"max_num_saves\": " << options.max_num_saves << ",\n";
+    ss << "  \"work\": " << work << ",\n";
+    ss << "  \"steps_per_second\": " << num((work - status_work)/seconds);
+    ss << ",\n";
+    ss << "  \"likelihood_calls\": " << get_likelihood_calls() << ",\n";
+    ss << "  \"barrier_wait_fraction\": ";
+    ss << num((explore_seconds > 0.0)?(wait_seconds/explore_seconds):(0.0));
+    ss << ",\n";
+    ss << "  \"pool_queue_depth\": " << pool->queue_depth() << ",\n";
+    ss << "  \"stash_size\": " << levels.get_stash_size() << ",\n";
+    ss << "  \"new_level_interval\": " << options.new_level_interval << ",\n";
+    ss << "  \"resident_memory_bytes\": " << Status::resident_memory();
+    ss << ",\n";
+    if(database.in_memory())
+        ss << "  \"snapshot_age_seconds\": "
+           << num(database.seconds_since_snapshot()) << ",\n";
+    else
+        ss << "  \"wal_bytes\": " << database.wal_size() << ",\n";
+    ss << "  \"push_is_active\": ";
+    ss << (levels.get_push_is_active()?"true":"false") << ",\n";
+    ss << "  \"levels\":\n  [\n";
+    int num_levels = levels.get_num_levels();
+    for(int i=0; i<num_levels; ++i)
+    {
+        auto tries = levels.get_tries(i);
+        double rate = (tries > 0)?(double(levels.get_accepts(i))/tries)
+                                 :(minus_infinity);
+        ss << "    {\"logx\": " << num(levels.get_logx(i)) << ", ";
+        ss << "\"logl\": " << num(std::get<0>(levels.get_pair(i))) << ", ";
+        ss << "\"visits\": " << levels.get_visits(i) << ", ";
+        ss << "\"tries\": " << tries << ", ";
+        ss << "\"acceptance_rate\": " << num(rate);
+        ss << "}" << ((i + 1 < num_levels)?(",\n"):("\n"));
+    }
+    ss << "  ]\n}";
+    status.write(ss.str());
+
+    // Rates are over the time since the last update
+    explore_seconds = 0.0;
+    wait_seconds = 0.0;
+    status_work = work;
+}
+
+#ifdef DNest5_TIMINGS
+template<typename T>
+inline void Sampler<T>::save_timings()
+{
+    // The other threads haven't touched their times since the barrier,
+    // so they are safe to read. Save what each did since the last save.
+    for(int i=0; i<options.num_threads; ++i)
+    {
+        auto& s = timings[i].seconds;
+        auto& last = saved_timings[i].seconds;
+        database.db << "INSERT INTO timings VALUES (?, ?, ?, ?, ?, ?, ?, ?);"
+                    << saved_particles << i
+                    << s[0] - last[0] << s[1] - last[1] << s[2] - last[2]
+                    << s[3] - last[3] << s[4] - last[4] << s[5] - last[5];
+        saved_timings[i] = timings[i];
+    }
+}
+#endif
+
+template<typename T>
+inline unsigned long long Sampler<T>::get_likelihood_calls() const
+{
+    unsigned long long calls = 0;
+    for(const auto& c: likelihood_calls)
+        calls += c.value;
+    return calls;
 }
 
 template<typename T>
@@ -210,18 +438,12 @@ inline void Sampler<T>::run_thread(int thread)
 
     while(true)
     {
-        // Print a message and start DB transaction
+        // Start a progress message, if one is due, and a DB transaction
         if(thread == 0 && !done)
         {
-            std::cout << "Exploring ["
-                      << levels.get_num_levels();
-            std::cout << " levels, ";
-            if(levels.get_push_is_active())
-                std::cout << "still building, ";
-            else
-                std::cout << "done building, ";
-            std::cout << "highest logl = "
-                      << std::get<0>(levels.get_top()) << "]..." << std::flush;
+            log_round = Logger::get().round_due();
+            if(log_round)
+                start_round_message();
 
             // Copy levels
             for(int i=0; i<options.num_threads; ++i)
@@ -234,16 +456,32 @@ inline void Sampler<T>::run_thread(int thread)
         }
 
         // Do a bit of MCMC (or quit)
-        barrier->wait();
+        {
+            DNest5_TIME(timings[thread], barrier);
+            barrier->wait();
+        }
         if(done)
             break;
+        if(thread == 0)
+            explore_time = std::chrono::steady_clock::now();
         explore(thread);
+        arrivals[thread].time = std::chrono::steady_clock::now();
         barrier->wait();
 
         if(thread == 0)
         {
-            std::cout << "done." << std::endl;
-
+            auto now = std::chrono::steady_clock::now();
+            explore_seconds += options.num_threads*
+                    std::chrono::duration<double>(now - explore_time).count();
+            for(int i=0; i<options.num_threads; ++i)
+            {
+                double wait = std::chrono::duration<double>(
+                                            now - arrivals[i].time).count();
+                wait_seconds += wait;
+#ifdef DNest5_TIMINGS
+                timings[i].seconds[int(Phase::barrier)] += wait;
+#endif
+            }
             // Add to work done
             work += options.save_interval;
 
@@ -253,40 +491,66 @@ inline void Sampler<T>::run_thread(int thread)
             ++saved_particles;
             if(full)
                 ++saved_full_particles;
-            save_particle(k, full);
+            {
+                DNest5_TIME(timings[0], saving);
+                save_particle(k, full);
+            }
             done = saved_particles >= (unsigned int)options.max_num_saves;
+            if(log_round)
+                finish_round_message();
 
             // Merge level data
-            auto backup = levels;
-            for(int i=0; i<options.num_threads; ++i)
+            bool created_level;
             {
-                for(int j=0; j<levels_copies[i].get_num_levels(); ++j)
+                DNest5_TIME(timings[0], level_merge);
+                auto backup = levels;
+                for(int i=0; i<options.num_threads; ++i)
                 {
-                    levels.adjust(j,
-                     levels_copies[i].get_exceeds(j) - backup.get_exceeds(j),
-                     levels_copies[i].get_visits(j) - backup.get_visits(j),
-                     levels_copies[i].get_accepts(j) - backup.get_accepts(j),
-                     levels_copies[i].get_tries(j) - backup.get_tries(j));
+                    for(int j=0; j<levels_copies[i].get_num_levels(); ++j)
+                    {
+                        levels.adjust(j,
+                         levels_copies[i].get_exceeds(j) - backup.get_exceeds(j),
+                         levels_copies[i].get_visits(j) - backup.get_visits(j),
+                         levels_copies[i].get_accepts(j) - backup.get_accepts(j),
+                         levels_copies[i].get_tries(j) - backup.get_tries(j),
+                         levels_copies[i].get_evaluations(j)
+                                                - backup.get_evaluations(j),
+                         levels_copies[i].get_early_exits(j)
+                                                - backup.get_early_exits(j));
+                    }
+                    levels.import_stash_from(levels_copies[i]);
                 }
-                levels.import_stash_from(levels_copies[i]);
+                created_level = levels.create_level();
+                if(created_level)
+                    level_seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_time).count();
+
+                // Level work
+                levels.revise();
+                levels.tune_scales();
             }
-            bool created_level = levels.create_level();
 
-            // Level work
-            levels.revise();
-            if(created_level || (saved_full_particles % options.level_save_gap == 0))
-                save_levels();
-            db << "COMMIT;";
+            {
+                DNest5_TIME(timings[0], saving);
+                if(created_level ||
+                   (saved_full_particles % options.level_save_gap == 0))
+                    save_levels();
+                db << "UPDATE samplers SET likelihood_calls = ? WHERE id = ?;"
+                   << get_likelihood_calls() << sampler_id;
+#ifdef DNest5_TIMINGS
+                save_timings();
+#endif
+                db << "COMMIT;";
+                database.limit_data_loss();
+            }
+            if(status.due())
+                write_status(false);
 
             // Check for any lagging particles
-            prune_laggards();
-
-            std::cout << "Work done = ";
-            std::cout << std::scientific << std::setprecision(3);
-            std::cout << double(work) << "." << std::endl;
-            std::cout << std::defaultfloat;
-            std::cout << std::setprecision(options.stdout_precision);
-            std::cout << std::endl;
+            {
+                DNest5_TIME(timings[0], level_merge);
+                prune_laggards();
+            }
         }
     }
 }
@@ -296,21 +560,80 @@ inline void Sampler<T>::explore(int thread)
 {
     // Temporary
     auto& rng = rngs[thread];
+    auto& order = batches[thread].order;
+    auto& swaps = batches[thread].swaps;
 
-    int k;
     int steps = options.save_interval/options.num_threads;
     int particles_per_thread = options.num_particles/options.num_threads;
-    for(int i=0; i<steps; ++i)
+    int batch_size = std::min(options.batch_size, particles_per_thread);
+    if(order.empty())
+        for(int i=0; i<particles_per_thread; ++i)
+            order.push_back(thread*particles_per_thread + i);
+    swaps.resize(batch_size);
+
+    // With num_tries > 1 the last batch may overshoot steps a little
+    for(int i=0; i<steps; )
     {
-        // Choose a particle
-        k = thread*particles_per_thread + rng.rand_int(particles_per_thread);
+        // Choose distinct particles by a partial shuffle, undone afterwards
+        // so that batches of one pick the same particles as always
+        int n = std::min(batch_size, steps - i);
+        for(int j=0; j<n; ++j)
+        {
+            swaps[j] = j + rng.rand_int(particles_per_thread - j);
+            std::swap(order[j], order[swaps[j]]);
+        }
+
+        // Do the Metropolis steps
+        i += metropolis_steps(std::span<const int>(order.data(), n), thread);
 
-        // Do a Metropolis step
-        metropolis_step(k, thread);
+        for(int j=n-1; j>=0; --j)
+            std::swap(order[j], order[swaps[j]]);
+    }
+}
 
-        // Add to stash
-        levels_copies[thread].add_to_stash(logl_tb(particles[k]));
+template<typename T>
+inline void Sampler<T>::start_round_message()
+{
+    auto message = Logger::stream();
+    message << "Exploring [" << levels.get_num_levels() << " levels, ";
+    if(levels.get_push_is_active())
+        message << "still building, ";
+    else
+        message << "done building, ";
+    message << "highest logl = " << std::get<0>(levels.get_top()) << ", ";
+    message << std::setprecision(3);
+    round_fields = {{"levels", levels.get_num_levels()},
+                    {"push_is_active", levels.get_push_is_active()},
+                    {"highest_logl", std::get<0>(levels.get_top())}};
+    if(database.in_memory())
+    {
+        double age = database.seconds_since_snapshot();
+        message << "snapshot age = " << age << " s";
+        round_fields.emplace_back("snapshot_age_seconds", age);
     }
+    else
+    {
+        auto wal = database.wal_size();
+        message << "WAL = " << wal/1048576.0 << " MB";
+        round_fields.emplace_back("wal_bytes", wal);
+    }
+    message << "]...";
+    round_message = message.str();
+}
+
+template<typename T>
+inline void Sampler<T>::finish_round_message()
+{
+    auto message = Logger::stream();
+    message << round_message << "done.\n";
+    message << "Saved particle " << saved_particles << " [";
+    message << saved_full_particles << " full particles].\n";
+    message << "Work done = " << std::scientific << std::setprecision(3);
+    message << double(work) << ".\n";
+    round_fields.emplace_back("saved_particles", saved_particles);
+    round_fields.emplace_back("saved_full_particles", saved_full_particles);
+    round_fields.emplace_back("work", work);
+    log_event(LogLevel::info, "round", message.str(), std::move(round_fields));
 }
 
 template<typename T>
@@ -328,7 +651,8 @@ inline void Sampler<T>::save_levels()
         // Upsert each level
         (*save_level_ps)
            << i << levels.get_logx(i) << logl << tb
-           << e << v << a << t;
+           << e << v << a << t << levels.get_log_scale(i)
+           << levels.get_evaluations(i) << levels.get_early_exits(i);
         (*save_level_ps)++;
     }
 }
@@ -345,66 +669,252 @@ inline void Sampler<T>::save_particle(int k, bool with_params)
         std::string s = t.to_string();
 
         // Bind values and execute prepared statement
-        (*save_particle_ps) << sampler_id << level << s << logl << tb;
+        if(compression.enabled() && !s.empty())
+            (*save_particle_ps) << sampler_id << level
+                                << compression.encode(s) << logl << tb;
+        else
+            (*save_particle_ps) << sampler_id << level << s << logl << tb;
     }
     else
         (*save_particle_ps) << sampler_id << level << nullptr << logl << tb;
 
 
     (*save_particle_ps)++;
-
-    // Stdout message
-    std::cout << "Saved particle ";
-    std::cout << saved_particles << " [" << saved_full_particles << " ";
-    std::cout << "full particles]." << std::endl;
 }
 
 
 
 template<typename T>
-inline bool Sampler<T>::metropolis_step(int k, int thread)
+inline int Sampler<T>::metropolis_steps(std::span<const int> ks, int thread)
 {
-    // Return value
-    bool accepted = false;
+    auto& batch = batches[thread];
+    batch.remaining.assign(ks.size(), options.num_tries);
+    batch.level_moved.assign(ks.size(), false);
+
+    // Rounds of proposals for the steps that are left, until there are none
+    int steps = 0;
+    while(std::any_of(batch.remaining.begin(), batch.remaining.end(),
+                      [](int r) { return r > 0; }))
+    {
+        {
+            DNest5_TIME(timings[thread], perturb);
+            make_proposals(ks, thread);
+        }
+        {
+            DNest5_TIME(timings[thread], log_likelihood);
+            evaluate_proposals(thread);
+        }
+        DNest5_TIME(timings[thread], record_stats);
+        steps += accept_proposals(ks, thread);
+    }
+    return steps;
+}
 
-    // Access correct RNG
+template<typename T>
+inline void Sampler<T>::make_proposals(std::span<const int> ks, int thread)
+{
     auto& rng = rngs[thread];
+    auto& batch = batches[thread];
+    int n = ks.size();
+
+    // Make the proposals, one for each step a particle has left, all from
+    // its current state (proposals first[i] to first[i+1] - 1 are particle
+    // i's)
+    batch.proposals.clear();
+    batch.passed.clear();
+    batch.level_first.resize(n);
+    batch.first.resize(n + 1);
+    for(int i=0; i<n; ++i)
+    {
+        int k = ks[i];
+        batch.first[i] = batch.proposals.size();
+        if(batch.remaining[i] == 0)
+            continue;
 
-    bool level_first = rng.rand() <= 0.5;
-    if(level_first)
-        metropolis_step_level(k, thread);
+        // The first step's level move, if it goes first
+        if(!batch.level_moved[i])
+        {
+            batch.level_first[i] = rng.rand() <= 0.5;
+            if(batch.level_first[i])
+                metropolis_step_level(k, thread);
+        }
 
-    // Unpack the particle and create a copy for the proposal
-    auto& particle = particles[k];
-    auto proposal = particle;
-    auto& [t, logl, tb, level] = particle;
-    auto& [t_prop, logl_prop, tb_prop, level_prop] = proposal;
+        for(int r=0; r<batch.remaining[i]; ++r)
+        {
+            // Create a copy of the particle for the proposal
+            batch.proposals.push_back(particles[k]);
+            auto& [t_prop, logl_prop, tb_prop, level_prop]
+                                                = batch.proposals.back();
+
+            // Perturb it, at the level's scale if the model takes one
+            double logh;
+            if constexpr(ScalesProposals<T>)
+                logh = t_prop.perturb(rng,
+                        exp(levels_copies[thread].get_log_scale(level_prop)));
+            else
+                logh = t_prop.perturb(rng);
 
-    // Make the proposal
-    double logh = t_prop.perturb(rng);
+            // Pre-reject
+            batch.passed.push_back(rng.rand() <= exp(logh));
+            if(batch.passed.back())
+            {
+                tb_prop += rng.randh();
+                wrap(tb_prop);
+            }
+        }
+    }
+    batch.first[n] = batch.proposals.size();
+}
 
-    // Pre-reject
-    if(rng.rand() <= exp(logh))
+template<typename T>
+inline void Sampler<T>::evaluate_proposals(int thread)
+{
+    auto& batch = batches[thread];
+
+    // Look up the survivors in the cache
+    auto& cache = caches[thread];
+    int m = batch.proposals.size();
+    batch.keys.resize(m);
+    batch.models.clear();
+    batch.thresholds.clear();
+    for(int i=0; i<m; ++i)
     {
-        logl_prop = t_prop.log_likelihood();
-        tb_prop += rng.randh(); wrap(tb_prop);
-        if(levels_copies[thread].get_pair(level) < Pair{logl_prop, tb_prop})
+        if(!batch.passed[i])
+            continue;
+        auto& [t_prop, logl_prop, tb_prop, level_prop] = batch.proposals[i];
+        if constexpr(HashesState<T>)
         {
-            accepted = true;
-            particle = proposal;
+            if(cache.enabled())
+            {
+                batch.keys[i] = t_prop.hash();
+                if(auto logl = cache.find(batch.keys[i]))
+                {
+                    logl_prop = *logl;
+                    continue;
+                }
+            }
         }
+        batch.models.push_back(&t_prop);
+        batch.thresholds.push_back(
+                std::get<0>(levels_copies[thread].get_pair(level_prop)));
     }
 
-    // Record stats
-    levels_copies[thread].record_stats(particle, accepted);
+    // Evaluate the rest, in one call if the model can take a batch, split
+    // over the pool
+    int num_models = batch.models.size();
+    batch.logls.resize(num_models);
+    batch.exited.assign(num_models, false);
+    pool->parallel_for(num_models, [&](int, long long begin, long long end)
+    {
+        auto models = std::span<const T* const>(batch.models)
+                                                .subspan(begin, end - begin);
+        auto logls = std::span<double>(batch.logls).subspan(begin, end - begin);
+        if constexpr(BatchedLikelihood<T>)
+            T::log_likelihood_batch(models, logls);
+        else
+        {
+            for(std::size_t j=0; j<models.size(); ++j)
+            {
+                auto logl = log_likelihood(*models[j],
+                                           batch.thresholds[begin + j]);
+                logls[j] = logl.value_or(minus_infinity);
+                batch.exited[begin + j] = !logl;
+            }
+        }
+    });
+    likelihood_calls[thread].value += num_models;
+
+    // Put the results in the proposals, and the cache (unless they stopped
+    // early, as then they are not the real log likelihood)
+    for(int i=0, j=0; i<m && j<num_models; ++i)
+    {
+        auto& [t_prop, logl_prop, tb_prop, level_prop] = batch.proposals[i];
+        if(&t_prop != batch.models[j])
+            continue;
+        logl_prop = batch.logls[j];
+        levels_copies[thread].record_evaluation(level_prop, batch.exited[j]);
+        if(cache.enabled() && !batch.exited[j])
+            cache.insert(batch.keys[i], logl_prop);
+        ++j;
+    }
+}
 
-    if(!level_first)
-        metropolis_step_level(k, thread);
+template<typename T>
+inline int Sampler<T>::accept_proposals(std::span<const int> ks, int thread)
+{
+    auto& rng = rngs[thread];
+    auto& batch = batches[thread];
+    int n = ks.size();
+
+    // Accept or reject, in order, doing exactly the steps that one try at a
+    // time would: each moves the level before or after, at random. The
+    // proposals were made from the particle at its level then, so once it
+    // is accepted or the level changes the rest are stale, and are made
+    // again next round.
+    int steps = 0;
+    for(int i=0; i<n; ++i)
+    {
+        int k = ks[i];
+        auto& particle = particles[k];
+        auto& [t, logl, tb, level] = particle;
 
-    return accepted;
+        for(int j=batch.first[i]; j<batch.first[i+1]; ++j)
+        {
+            // The first step's level move was done by make_proposals
+            int old_level = level;
+            if(j > batch.first[i])
+            {
+                batch.level_first[i] = rng.rand() <= 0.5;
+                if(batch.level_first[i])
+                {
+                    metropolis_step_level(k, thread);
+                    if(level != old_level)
+                    {
+                        batch.level_moved[i] = true;
+                        break;
+                    }
+                }
+            }
+
+            auto& proposal = batch.proposals[j];
+            auto& [t_prop, logl_prop, tb_prop, level_prop] = proposal;
+
+            bool accepted = batch.passed[j] &&
+                 levels_copies[thread].get_pair(level) < Pair{logl_prop, tb_prop};
+            if(accepted)
+                particle = std::move(proposal);
+
+            // Record stats and add to stash
+            levels_copies[thread].record_stats(particle, accepted);
+            levels_copies[thread].add_to_stash(logl_tb(particle));
+            ++steps;
+            --batch.remaining[i];
+            batch.level_moved[i] = false;
+
+            if(!batch.level_first[i])
+                metropolis_step_level(k, thread);
+
+            if(accepted || level != old_level)
+                break;
+        }
+    }
+
+    return steps;
 }
 
 
+template<typename T>
+inline std::optional<double> Sampler<T>::log_likelihood(const T& t,
+                                                        double threshold)
+{
+    if constexpr(ExitsEarly<T>)
+        return t.log_likelihood(threshold);
+    else if constexpr(UsesThreadPool<T>)
+        return t.log_likelihood(*pool);
+    else
+        return t.log_likelihood();
+}
+
 template<typename T>
 inline void Sampler<T>::metropolis_step_level(int k, int thread)
 {
@@ -466,16 +976,26 @@ inline void Sampler<T>::prune_laggards()
             int j = rngs[0].rand_int(options.num_particles);
             particles[i] = particles_copy[j];
             ++pruned;
+
+            // The clone's likelihood is known, so tell the cache of the
+            // thread that now owns it
+            int owner = i/(options.num_particles/options.num_threads);
+            const auto& [t, logl, tb, level] = particles[i];
+            if constexpr(HashesState<T>)
+                if(owner < options.num_threads && caches[owner].enabled())
+                    caches[owner].insert(t.hash(), logl);
         }
     }
     if(pruned > 0)
     {
-        std::cout << pruned << " lagging particle";
+        auto message = Logger::stream();
+        message << pruned << " lagging particle";
         if(pruned == 1)
-            std::cout << " has ";
+            message << " has ";
         else
-            std::cout << "s have ";
-        std::cout << "been pruned." << std::endl;
+            message << "s have ";
+        message << "been pruned.";
+        log_event(LogLevel::info, "pruned", message.str(), {{"pruned", pruned}});
     }
 }
 
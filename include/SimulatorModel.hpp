@@ -0,0 +1,137 @@
+#ifndef DNest5_SimulatorModel_hpp
+#define DNest5_SimulatorModel_hpp
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace DNest5
+{
+
+/*
+    Derive from this class to implement simulator-based (ABC) models. The
+    derived class T provides
+        std::size_t simulation_size() const;
+        void simulate(std::span<double> out) const;
+        static Summaries summaries(std::span<const double> data);
+    where simulate() writes a fake dataset, which must be a deterministic
+    function of the parameters (put any noise in the parameters, as the ABC
+    example does). T's load_data() calls set_observed() once.
+
+    log_likelihood() is then minus the distance between the summaries of the
+    simulated and the observed data, so the levels form a ladder of shrinking
+    distance thresholds and postprocess -a works as usual. The distance is
+    L1 unless T has a static distance(const Summaries&, const Summaries&).
+
+    Simulations go into a buffer that each thread keeps and reuses, and
+    log_likelihood_batch() does several models per call so that Sampler can
+    hand over a batch of proposals (see batch_size in options.yaml). T may
+    provide a static simulate_batch(models, out), writing the simulations
+    one after the other, to do the batch in one go.
+*/
+template<typename T, int num_summaries>
+class SimulatorModel
+{
+    public:
+        using Summaries = std::array<double, num_summaries>;
+
+    private:
+        static Summaries observed;
+
+        static double summary_distance(const Summaries& x, const Summaries& y);
+
+        // The calling thread's simulation buffer, at least size doubles
+        static std::span<double> buffer(std::size_t size);
+
+    protected:
+        // Cache the summaries of the observed data
+        static void set_observed(std::span<const double> data);
+
+    public:
+        inline double log_likelihood() const;
+
+        // logls[i] = models[i]->log_likelihood()
+        static inline void log_likelihood_batch(std::span<const T* const> models,
+                                                std::span<double> logls);
+};
+
+/* Implementations follow */
+
+template<typename T, int num_summaries>
+typename SimulatorModel<T, num_summaries>::Summaries
+    SimulatorModel<T, num_summaries>::observed{};
+
+template<typename T, int num_summaries>
+void SimulatorModel<T, num_summaries>::set_observed(std::span<const double> data)
+{
+    observed = T::summaries(data);
+}
+
+template<typename T, int num_summaries>
+double SimulatorModel<T, num_summaries>::summary_distance(const Summaries& x,
+                                                          const Summaries& y)
+{
+    if constexpr(requires { T::distance(x, y); })
+        return T::distance(x, y);
+    else
+    {
+        double d = 0.0;
+        for(int i=0; i<num_summaries; ++i)
+            d += std::abs(x[i] - y[i]);
+        return d;
+    }
+}
+
+template<typename T, int num_summaries>
+std::span<double> SimulatorModel<T, num_summaries>::buffer(std::size_t size)
+{
+    thread_local std::vector<double> values;
+    if(values.size() < size)
+        values.resize(size);
+    return std::span<double>(values.data(), size);
+}
+
+template<typename T, int num_summaries>
+inline double SimulatorModel<T, num_summaries>::log_likelihood() const
+{
+    const T& t = static_cast<const T&>(*this);
+    auto sim = buffer(t.simulation_size());
+    t.simulate(sim);
+    return -summary_distance(T::summaries(sim), observed);
+}
+
+template<typename T, int num_summaries>
+inline void SimulatorModel<T, num_summaries>::log_likelihood_batch(
+                                        std::span<const T* const> models,
+                                        std::span<double> logls)
+{
+    if constexpr(requires(std::span<double> out)
+                        { T::simulate_batch(models, out); })
+    {
+        std::size_t total = 0;
+        for(const T* t: models)
+            total += t->simulation_size();
+        auto sims = buffer(total);
+        T::simulate_batch(models, sims);
+
+        std::size_t start = 0;
+        for(std::size_t i=0; i<models.size(); ++i)
+        {
+            auto sim = sims.subspan(start, models[i]->simulation_size());
+            logls[i] = -summary_distance(T::summaries(sim), observed);
+            start += sim.size();
+        }
+    }
+    else
+    {
+        for(std::size_t i=0; i<models.size(); ++i)
+            logls[i] = models[i]->log_likelihood();
+    }
+}
+
+} // namespace
+
+#endif
+
@@ -0,0 +1,47 @@
+#ifndef DNest5_Status_h
+#define DNest5_Status_h
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace DNest5
+{
+
+/*
+* Live metrics of a run, as a JSON file for monitoring tools (see status.py).
+* Each write goes to a temporary file that is then renamed over the old one,
+* so readers always see a whole file and never interact with the sampler.
+* Sampler writes it between saves, while its other threads are waiting at
+* the barrier, at most once per interval.
+*/
+class Status
+{
+    private:
+        std::string filename;
+        std::optional<double> interval;
+        std::chrono::steady_clock::time_point last_write;
+
+    public:
+        // No interval means never write
+        Status(std::string _filename, std::optional<double> _interval);
+
+        // Whether the interval has passed since the last write
+        bool due() const;
+        double seconds_since_write() const;
+
+        // Replace the file's contents
+        void write(const std::string& json);
+
+        // A double as JSON, with null for infinities and NaNs
+        static std::string number(double x);
+
+        // Resident memory of this process in bytes, or zero if unknown
+        static std::uintmax_t resident_memory();
+};
+
+} // namespace
+
+#endif
+
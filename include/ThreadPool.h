@@ -0,0 +1,114 @@
+#ifndef DNest5_ThreadPool_h
+#define DNest5_ThreadPool_h
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DNest5
+{
+
+/*
+* A fixed set of worker threads that run submitted tasks. With one thread
+* (or fewer) there are no workers and tasks run immediately on the caller.
+*/
+class ThreadPool
+{
+    private:
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable task_available, tasks_finished;
+        int busy;
+        std::atomic<int> queued;
+        bool stopping;
+
+        // What each worker thread does
+        void work();
+
+        // Progress of one parallel_for
+        struct Progress
+        {
+            std::atomic<int> next, remaining;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+
+    public:
+
+        ThreadPool(int num_threads);
+        ~ThreadPool();
+
+        // Number of tasks that can run at once
+        inline int size() const
+        { return (workers.size() > 0)?(int(workers.size())):(1); }
+
+        // Queue a task
+        void submit(std::function<void()> task);
+
+        // Block until every submitted task has finished
+        void wait();
+
+        // Tasks waiting for a worker, without locking
+        inline int queue_depth() const
+        { return queued.load(std::memory_order_relaxed); }
+
+        // Split [0, n) into up to size() contiguous blocks, call
+        // f(block, begin, end) for each, and wait for them all. The caller
+        // runs blocks too and only waits for its own, so this may be called
+        // from several threads at once, and from inside f, without
+        // deadlocking or running more threads than the pool has.
+        template<typename F>
+        inline void parallel_for(long long n, F&& f);
+};
+
+/* TEMPLATE IMPLEMENTATIONS */
+
+template<typename F>
+inline void ThreadPool::parallel_for(long long n, F&& f)
+{
+    int blocks = std::min<long long>(size(), n);
+    if(blocks <= 1)
+    {
+        f(0, 0, n);
+        return;
+    }
+
+    // Whoever gets to a block first runs it. Workers that arrive after
+    // they are all taken just return, so f is never used after this does.
+    auto progress = std::make_shared<Progress>();
+    progress->next = 0;
+    progress->remaining = blocks;
+    auto run_blocks = [progress, &f, n, blocks]()
+    {
+        int i;
+        while((i = progress->next++) < blocks)
+        {
+            f(i, (n*i)/blocks, (n*(i+1))/blocks);
+            if(--progress->remaining == 0)
+            {
+                std::lock_guard<std::mutex> lock(progress->mutex);
+                progress->finished.notify_all();
+            }
+        }
+    };
+
+    for(int i=1; i<blocks; ++i)
+        submit(run_blocks);
+    run_blocks();
+
+    std::unique_lock<std::mutex> lock(progress->mutex);
+    progress->finished.wait(lock, [&]() { return progress->remaining == 0; });
+}
+
+} // namespace
+
+#endif
+
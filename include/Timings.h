@@ -0,0 +1,71 @@
+#ifndef DNest5_Timings_h
+#define DNest5_Timings_h
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace DNest5
+{
+
+/*
+* Where the sampler's time goes, per thread. Only used when DNest5_TIMINGS
+* is defined, e.g. make FLAGS="-O3 -march=native -std=c++2a -DDNest5_TIMINGS".
+* Otherwise DNest5_TIME expands to nothing and Sampler has no timing code.
+*/
+enum class Phase
+{
+    perturb, log_likelihood, record_stats, barrier, level_merge, saving
+};
+static constexpr int num_phases = 6;
+
+// Also the column names of the timings table
+static constexpr std::array<std::string_view, num_phases> phase_names
+    {"perturb", "log_likelihood", "record_stats", "barrier", "level_merge",
+     "saving"};
+
+// Seconds spent in each phase by one thread, on cache lines of its own
+struct alignas(64) PhaseTimes
+{
+    std::array<double, num_phases> seconds{};
+
+    // Totals over all threads, as a table with percentages
+    static std::string report(std::span<const PhaseTimes> times);
+};
+
+// Adds the time until it goes out of scope to one phase
+class PhaseTimer
+{
+    private:
+        double& total;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        PhaseTimer(PhaseTimes& times, Phase phase)
+        :total(times.seconds[int(phase)])
+        ,start(std::chrono::steady_clock::now())
+        {
+
+        }
+
+        ~PhaseTimer()
+        {
+            auto end = std::chrono::steady_clock::now();
+            total += std::chrono::duration<double>(end - start).count();
+        }
+};
+
+} // namespace
+
+// Time the rest of the enclosing scope as one phase
+#ifdef DNest5_TIMINGS
+#define DNest5_TIME(times, phase) \
+    DNest5::PhaseTimer dnest5_phase_timer(times, DNest5::Phase::phase)
+#else
+#define DNest5_TIME(times, phase)
+#endif
+
+#endif
+
@@ -1,6 +1,8 @@
 #ifndef DNest5_UniformModel_hpp
 #define DNest5_UniformModel_hpp
 
+#include "FixedString.h"
+#include "LikelihoodCache.h"
 #include "Options.h"
 #include "ParameterNames.h"
 
@@ -19,7 +21,15 @@ using Tools::logsumexp, Tools::RNG, Tools::qnorm, Tools::wrap;
 
 /*
     Derive from this class to implement models using an underlying
-    set of coordinates with Uniform(0, 1) priors.
+    set of coordinates with Uniform(0, 1) priors. The derived class T
+    provides us_to_params() and log_likelihood(). They are found through
+    T at compile time (CRTP), so there are no virtual calls.
+
+    T may also name its parameters with a constexpr list, e.g.,
+        static constexpr std::array<std::string_view, 3> names
+                                            {"m", "b", "sigma"};
+    in which case param<"m">() is xs[0], with the index worked out at
+    compile time, and parameter_names (for CSV headers) uses the names.
 */
 template<int num_params, typename T>
 class UniformModel
@@ -34,30 +44,56 @@ class UniformModel
 
         // Default constructor sets up the vectors
         inline UniformModel(RNG& rng);
-        inline virtual ~UniformModel() = default;
 
-        // Functions specified here and not to be overridden
-        inline double perturb(RNG& rng);
+        // Functions specified here and not to be overridden. The scale
+        // multiplies the step sizes.
+        inline double perturb(RNG& rng, double scale = 1.0);
         inline std::vector<char> to_blob() const;
         inline void from_blob(const std::vector<char>& vec);
         inline std::string to_string() const;
 
+        // Hash of the coordinates, for LikelihoodCache
+        std::uint64_t hash() const { return LikelihoodCache::hash(us); }
+
         // Access parameters by name
-        inline virtual double& param(std::string&& name);
-        inline virtual const double& param(std::string&& name) const;
+        inline double& param(std::string&& name);
+        inline const double& param(std::string&& name) const;
 
-        // Functions to be specified in the derived class
-        inline virtual void us_to_params() = 0;
-        inline virtual double log_likelihood() const = 0;
+        // Access parameters by name, resolved at compile time from T::names
+        template<FixedString name>
+        inline double& param();
+        template<FixedString name>
+        inline const double& param() const;
 
         // This is the default naming scheme, but it may or may not be used
         static const ParameterNames parameter_names;
+
+    private:
+        template<FixedString name>
+        static constexpr int index();
+
+        static ParameterNames default_parameter_names();
 };
 
 /* Implementations follow */
 
 template<int num_params, typename T>
-const ParameterNames UniformModel<num_params, T>::parameter_names(num_params);
+const ParameterNames UniformModel<num_params, T>::parameter_names
+                                            = default_parameter_names();
+
+template<int num_params, typename T>
+ParameterNames UniformModel<num_params, T>::default_parameter_names()
+{
+    if constexpr(requires { T::names; })
+    {
+        static_assert(std::size(T::names) == num_params,
+                      "T::names must have num_params names.");
+        return ParameterNames(std::vector<std::string>(std::begin(T::names),
+                                                       std::end(T::names)));
+    }
+    else
+        return ParameterNames(num_params);
+}
 
 template<int num_params, typename T>
 inline UniformModel<num_params, T>::UniformModel(RNG& rng)
@@ -69,7 +105,7 @@ inline UniformModel<num_params, T>::UniformModel(RNG& rng)
 }
 
 template<int num_params, typename T>
-inline double UniformModel<num_params, T>::perturb(RNG& rng)
+inline double UniformModel<num_params, T>::perturb(RNG& rng, double scale)
 {
     int num = 1;
     if(rng.rand() <= 0.5)
@@ -78,10 +114,10 @@ inline double UniformModel<num_params, T>::perturb(RNG& rng)
     for(int i=0; i<num; ++i)
     {
         int k = rng.rand_int(us.size());
-        us[k] += rng.randh();
+        us[k] += scale*rng.randh();
         wrap(us[k]);
     }
-    us_to_params();
+    static_cast<T&>(*this).us_to_params();
 
     return 0.0;
 }
@@ -148,6 +184,29 @@ inline const double& UniformModel<num_params, T>::param(std::string&& name) cons
     return xs[T::parameter_names.index(std::move(name))];
 }
 
+template<int num_params, typename T>
+template<FixedString name>
+constexpr int UniformModel<num_params, T>::index()
+{
+    constexpr int i = index_of(T::names, name.view());
+    static_assert(i >= 0, "No parameter with this name in T::names.");
+    return i;
+}
+
+template<int num_params, typename T>
+template<FixedString name>
+inline double& UniformModel<num_params, T>::param()
+{
+    return xs[index<name>()];
+}
+
+template<int num_params, typename T>
+template<FixedString name>
+inline const double& UniformModel<num_params, T>::param() const
+{
+    return xs[index<name>()];
+}
+
 } // namespace
 
 #endif
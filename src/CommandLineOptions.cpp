@@ -7,15 +7,17 @@ namespace DNest5
 	// http://www.gnu.org/software/libc/manual/html_node/Example-of-Getopt.html#Example-of-Getopt
 
 CommandLineOptions::CommandLineOptions(int argc, char** argv)
-:temperature(1.0)
+:temperatures{1.0}
 ,abc(false)
 ,abc_fraction(0.8)
+,memory_budget(1024.0)
+,num_threads(1)
+,num_replicates(0)
 {
 	int c;
-	std::stringstream ss;
 
 	opterr = 0;
-	while((c = getopt(argc, argv, "haf:t:")) != -1)
+	while((c = getopt(argc, argv, "haf:j:m:t:u:")) != -1)
     {
 	    switch(c)
 	    {
@@ -26,12 +28,19 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
                 abc = true;
                 break;
             case 'f':
-                ss << optarg;
-                ss >> abc_fraction;
+                std::stringstream(optarg) >> abc_fraction;
+                break;
+            case 'j':
+                std::stringstream(optarg) >> num_threads;
+                break;
+            case 'm':
+                std::stringstream(optarg) >> memory_budget;
                 break;
             case 't':
-                ss << optarg;
-                ss >> temperature;
+                temperatures = parse_temperatures(optarg);
+                break;
+            case 'u':
+                std::stringstream(optarg) >> num_replicates;
                 break;
 		    case '?':
 			    std::cerr << "# Option "<< optopt <<" requires an argument." <<std::endl;
@@ -48,7 +57,7 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 	for(int index = optind; index < argc; index++)
 		std::cerr << "# Non-option argument " << argv[index] << std::endl;
 
-    if(abc && temperature != 1.0)
+    if(abc && (temperatures.size() > 1 || temperatures[0] != 1.0))
         std::cerr << "Temperature option has no effect in ABC mode." << std::endl;
 
     if(!abc && abc_fraction != 0.8)
@@ -59,10 +68,72 @@ void CommandLineOptions::print_help() const
 {
     std::cout << "Command line options for postprocessing:" << std::endl;
     std::cout << "    -t <temperature>     (default=1.0)" << std::endl;
+    std::cout << "    -t <t1,t2,...>       (several temperatures, the first";
+    std::cout << " is used for the posterior samples)" << std::endl;
+    std::cout << "    -t <min:max:num>     (num evenly spaced temperatures)";
+    std::cout << std::endl;
     std::cout << "    -a                   (ABC mode)" << std::endl;
     std::cout << "    -f <abc_fraction>    (default=0.8)" << std::endl;
+    std::cout << "    -j <num_threads>     (default=1)" << std::endl;
+    std::cout << "    -m <memory_budget>   (in MB, default=1024)" << std::endl;
+    std::cout << "    -u <num_replicates>  (logz uncertainty, default=0)";
+    std::cout << std::endl;
     exit(0);
 }
 
+std::vector<double> CommandLineOptions::parse_temperatures(const std::string& arg)
+{
+    std::vector<double> result;
+    std::stringstream ss(arg);
+    std::string token;
+
+    if(arg.find(':') != std::string::npos)
+    {
+        double min, max;
+        int num;
+        char colon1, colon2;
+        if(!(ss >> min >> colon1 >> max >> colon2 >> num) || num < 1)
+        {
+            std::cerr << "# Could not parse temperature range " << arg << ".";
+            std::cerr << std::endl;
+            exit(-1);
+        }
+        for(int i=0; i<num; ++i)
+        {
+            if(num == 1)
+                result.push_back(min);
+            else
+                result.push_back(min + (max - min)*i/(num - 1));
+        }
+    }
+    else
+    {
+        while(std::getline(ss, token, ','))
+        {
+            double temperature;
+            if(!(std::stringstream(token) >> temperature))
+            {
+                std::cerr << "# Could not parse temperature " << token << ".";
+                std::cerr << std::endl;
+                exit(-1);
+            }
+            result.push_back(temperature);
+        }
+    }
+
+    for(double temperature: result)
+    {
+        if(temperature <= 0.0)
+        {
+            std::cerr << "# Temperatures must be positive." << std::endl;
+            exit(-1);
+        }
+    }
+    if(result.size() == 0)
+        result.push_back(1.0);
+
+    return result;
+}
+
 } // namespace
 
@@ -0,0 +1,96 @@
+#include "Compression.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <zlib.h>
+
+namespace DNest5
+{
+
+Compression::Compression(const std::string& name)
+:use_zlib(name == "zlib")
+,raw_bytes(0)
+,stored_bytes(0)
+,seconds(0.0)
+{
+    if(name != "none" && name != "zlib")
+    {
+        std::cerr << "Unknown compression '" << name << "'. ";
+        std::cerr << "Use none or zlib." << std::endl;
+        exit(-1);
+    }
+}
+
+std::vector<char> Compression::encode(const std::string& text)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    uLongf size = compressBound(text.size());
+    std::vector<char> result(header_size + size);
+    result[0] = 0;
+    uint32_t n = text.size();
+    for(int i=0; i<4; ++i)
+        result[1+i] = char((n >> (8*i)) & 0xFF);
+
+    // Fastest level, since this is on the sampler's critical path
+    int status = compress2(reinterpret_cast<Bytef*>(&result[header_size]),
+                           &size, reinterpret_cast<const Bytef*>(text.data()),
+                           text.size(), Z_BEST_SPEED);
+    if(status != Z_OK)
+    {
+        std::cerr << "zlib error " << status << " compressing params.";
+        std::cerr << std::endl;
+        exit(-1);
+    }
+    result.resize(header_size + size);
+    if(result.size() >= text.size())
+        result.assign(text.begin(), text.end());
+
+    auto end = std::chrono::steady_clock::now();
+    raw_bytes += text.size();
+    stored_bytes += result.size();
+    seconds += std::chrono::duration<double>(end - start).count();
+
+    return result;
+}
+
+std::string Compression::decode(const std::vector<char>& value)
+{
+    // Plain text
+    if(value.size() < size_t(header_size) || value[0] != 0)
+        return std::string(value.begin(), value.end());
+
+    uint32_t n = 0;
+    for(int i=0; i<4; ++i)
+        n |= uint32_t((unsigned char)value[1+i]) << (8*i);
+
+    std::string text(n, '\0');
+    uLongf size = n;
+    int status = uncompress(reinterpret_cast<Bytef*>(text.data()), &size,
+                            reinterpret_cast<const Bytef*>(&value[header_size]),
+                            value.size() - header_size);
+    if(status != Z_OK || size != n)
+    {
+        std::cerr << "zlib error " << status << " decompressing params.";
+        std::cerr << std::endl;
+        exit(-1);
+    }
+    return text;
+}
+
+std::string Compression::report() const
+{
+    std::stringstream ss;
+    ss << std::setprecision(4);
+    ss << "Params compression ratio = ";
+    ss << (stored_bytes > 0 ? double(raw_bytes)/stored_bytes : 1.0);
+    ss << " (" << raw_bytes << " -> " << stored_bytes << " bytes), ";
+    ss << seconds << " CPU seconds.";
+    return ss.str();
+}
+
+} // namespace
+
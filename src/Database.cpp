@@ -1,30 +1,328 @@
 #include "Database.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
 
 namespace DNest5
 {
 
-Database::Database()
-:db("output/dnest5.db")
+Database::Database(const std::string& _filename,
+                   std::optional<double> _snapshot_interval,
+                   double _max_data_loss)
+:filename(_filename)
+,snapshot_interval(_snapshot_interval)
+,max_data_loss(_max_data_loss)
+,db(in_memory() ? std::string(":memory:") : filename)
+,stopping(false)
+,last_snapshot(0)
 {
-    std::cout << "Initialising database." << std::endl;
+    log_event(LogLevel::info, "database",
+              in_memory()?"Initialising database in memory."
+                         :"Initialising database.",
+              {{"filename", filename}, {"in_memory", in_memory()}});
+
+    // Start from whatever is on disk already
+    if(in_memory() && std::filesystem::exists(filename))
+    {
+        sqlite::database disk(filename);
+        copy(disk, db, -1);
+    }
 
     pragmas();
     db << "BEGIN;";
+    migrate();
     create_tables();
     create_indexes();
     create_views();
     db << "COMMIT;";
     db << "VACUUM;";
+
+    if(in_memory())
+    {
+        snapshot();
+        background_thread = std::thread(&Database::snapshot_loop, this);
+    }
+    else
+        background_thread = std::thread(&Database::checkpoint_loop, this);
+}
+
+Database::~Database()
+{
+    {
+        std::lock_guard<std::mutex> lock(background_mutex);
+        stopping = true;
+    }
+    background_cv.notify_all();
+    background_thread.join();
+
+    // The owner of an in-memory database calls snapshot() at the end
+    if(in_memory())
+        return;
+
+    // Leave an empty WAL behind if no reader is still using it
+    try
+    {
+        checkpoint(db, true);
+    }
+    catch(const sqlite::sqlite_exception& e)
+    {
+        std::cerr << "Final checkpoint failed: " << e.what() << std::endl;
+    }
+}
+
+void Database::checkpoint_loop()
+{
+    // No busy timeout, so a checkpoint never waits for anybody
+    sqlite::database connection(filename);
+
+    std::unique_lock<std::mutex> lock(background_mutex);
+    while(true)
+    {
+        background_cv.wait_for(lock,
+                        std::chrono::milliseconds(checkpoint_interval_ms),
+                        [&]() { return stopping; });
+        if(stopping)
+            break;
+        if(wal_size() < wal_checkpoint_bytes)
+            continue;
+
+        // A busy database is left until next time
+        try
+        {
+            bool complete = checkpoint(connection, false);
+            if(complete && wal_size() > wal_size_limit)
+                checkpoint(connection, true);
+        }
+        catch(const sqlite::sqlite_exception&)
+        {
+
+        }
+    }
+}
+
+void Database::snapshot_loop()
+{
+    std::unique_lock<std::mutex> lock(background_mutex);
+    while(true)
+    {
+        background_cv.wait_for(lock,
+                        std::chrono::duration<double>(*snapshot_interval),
+                        [&]() { return stopping; });
+        if(stopping)
+            break;
+        snapshot_locked();
+    }
+}
+
+int Database::copy(sqlite::database& from, sqlite::database& to,
+                   int pages_per_step)
+{
+    sqlite3_backup* backup = sqlite3_backup_init(to.connection().get(), "main",
+                                                 from.connection().get(), "main");
+    if(!backup)
+        return sqlite3_errcode(to.connection().get());
+
+    // While the source connection is writing, steps return SQLITE_LOCKED.
+    // Changes it commits in between are applied to the copy as well.
+    int rc;
+    do
+    {
+        rc = sqlite3_backup_step(backup, pages_per_step);
+        if(rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        else
+            std::this_thread::yield();
+    }while(rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+    sqlite3_backup_finish(backup);
+
+    return rc;
+}
+
+void Database::snapshot()
+{
+    if(!in_memory())
+        return;
+    std::lock_guard<std::mutex> lock(background_mutex);
+    snapshot_locked();
+}
+
+void Database::snapshot_locked()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Readers of the file see either the old snapshot or the new one
+    sqlite::database disk(filename);
+    disk << "PRAGMA PAGE_SIZE = " + std::to_string(page_size) + ";";
+    disk << "PRAGMA JOURNAL_MODE = WAL;";
+    disk << "PRAGMA BUSY_TIMEOUT = " + std::to_string(busy_timeout_ms) + ";";
+
+    int rc = copy(db, disk, snapshot_pages_per_step);
+    if(rc != SQLITE_DONE)
+    {
+        // The previous snapshot is still intact, so carry on
+        std::cerr << "Snapshot to " << filename << " failed: ";
+        std::cerr << sqlite3_errstr(rc) << std::endl;
+        return;
+    }
+
+    // Data committed before the start is safe
+    last_snapshot = std::chrono::duration_cast<std::chrono::nanoseconds>
+                            (start.time_since_epoch()).count();
+}
+
+double Database::seconds_since_snapshot() const
+{
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>
+                (std::chrono::steady_clock::now().time_since_epoch()).count();
+    return 1E-9*(now - last_snapshot);
+}
+
+void Database::limit_data_loss()
+{
+    if(!in_memory() || seconds_since_snapshot() <= max_data_loss)
+        return;
+
+    // A snapshot may have finished while waiting for the lock
+    std::lock_guard<std::mutex> lock(background_mutex);
+    if(seconds_since_snapshot() > max_data_loss)
+    {
+        auto message = Logger::stream();
+        message << "Snapshot is older than " << max_data_loss;
+        message << " seconds, waiting for a new one.";
+        log_event(LogLevel::warning, "snapshot_wait", message.str(),
+                  {{"max_data_loss", max_data_loss}});
+        snapshot_locked();
+    }
+}
+
+bool Database::checkpoint(sqlite::database& connection, bool truncate)
+{
+    int busy = 1, frames = 0, checkpointed = 0;
+    connection << (truncate ? "PRAGMA WAL_CHECKPOINT(TRUNCATE);"
+                            : "PRAGMA WAL_CHECKPOINT(PASSIVE);") >>
+        [&](int _busy, int _frames, int _checkpointed)
+        {
+            busy = _busy;
+            frames = _frames;
+            checkpointed = _checkpointed;
+        };
+    return busy == 0 && frames == checkpointed;
+}
+
+std::uintmax_t Database::wal_size() const
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(filename + "-wal", error);
+    return error ? 0 : size;
 }
 
 void Database::pragmas()
 {
+    // Page size only takes effect on a new file, so it comes before WAL.
+    // An in-memory copy of an existing file keeps the file's page size, or
+    // snapshots (which go to a WAL database) would fail.
+    int num_pages = 0;
+    db << "PRAGMA PAGE_COUNT;" >> num_pages;
+    if(num_pages == 0)
+        db << "PRAGMA PAGE_SIZE = " + std::to_string(page_size) + ";";
     db << "PRAGMA SYNCHRONOUS = 0;";
     db << "PRAGMA JOURNAL_MODE = WAL;";
+    db << "PRAGMA WAL_AUTOCHECKPOINT = 0;";
+    db << "PRAGMA JOURNAL_SIZE_LIMIT = " + std::to_string(wal_size_limit) + ";";
+    reader_pragmas(db);
+}
+
+void Database::reader_pragmas(sqlite::database& connection)
+{
+    connection << "PRAGMA CACHE_SIZE = -" + std::to_string(cache_size_kib) + ";";
+    connection << "PRAGMA MMAP_SIZE = " + std::to_string(mmap_size) + ";";
+
+    // Wait out a truncating checkpoint instead of failing
+    connection << "PRAGMA BUSY_TIMEOUT = " + std::to_string(busy_timeout_ms) + ";";
+}
+
+int Database::schema_version()
+{
+    // Version 0 is an empty file. Version 1 predates the schema_version
+    // table, so it is recognised by the presence of the particles table.
+    int count;
+    db << "SELECT COUNT(*) FROM sqlite_master\
+           WHERE type = 'table' AND name = 'schema_version';" >> count;
+    if(count > 0)
+    {
+        int version = 0;
+        db << "SELECT MAX(version) FROM schema_version;" >> version;
+        return version;
+    }
+
+    db << "SELECT COUNT(*) FROM sqlite_master\
+           WHERE type = 'table' AND name = 'particles';" >> count;
+    return (count > 0)?(1):(0);
+}
+
+void Database::migrate()
+{
+    int version = schema_version();
+    if(version > current_schema_version)
+    {
+        std::cerr << "Database schema version " << version << " is newer ";
+        std::cerr << "than this code (" << current_schema_version << ").";
+        std::cerr << std::endl;
+        exit(-1);
+    }
+
+    // 1 -> 2: particle_logl_tb_idx is replaced by particle_logl_tb_full_idx,
+    // which was built at the end of a run instead of on every insert
+    if(version == 1)
+        db << "DROP INDEX IF EXISTS particle_logl_tb_idx;";
+
+    // 2 -> 3: samplers.likelihood_calls and levels.log_scale
+    if(version == 1 || version == 2)
+    {
+        db << "ALTER TABLE samplers ADD COLUMN\
+               likelihood_calls INTEGER NOT NULL DEFAULT 0;";
+        db << "ALTER TABLE levels ADD COLUMN\
+               log_scale REAL NOT NULL DEFAULT 0.0;";
+    }
+
+    // 3 -> 4: levels.evaluations and levels.early_exits
+    if(version >= 1 && version <= 3)
+    {
+        db << "ALTER TABLE levels ADD COLUMN\
+               evaluations INTEGER NOT NULL DEFAULT 0;";
+        db << "ALTER TABLE levels ADD COLUMN\
+               early_exits INTEGER NOT NULL DEFAULT 0;";
+    }
+
+    // 4 -> 5: the timings table, which create_tables() adds
+
+    // 5 -> 6: particle_logl_tb_full_idx is dropped, since postprocess now
+    // reads particles by id range and nothing else used it
+    if(version >= 2 && version <= 5)
+        db << "DROP INDEX IF EXISTS particle_logl_tb_full_idx;";
+
+    if(version != 0 && version < current_schema_version)
+    {
+        auto message = Logger::stream();
+        message << "Migrated database from schema version " << version;
+        message << " to " << current_schema_version << ".";
+        log_event(LogLevel::info, "migrated", message.str(),
+                  {{"from", version}, {"to", current_schema_version}});
+    }
 }
 
 void Database::create_tables()
 {
+    db <<
+"CREATE TABLE IF NOT EXISTS schema_version\n\
+    (version INTEGER NOT NULL PRIMARY KEY);";
+
+    db << "DELETE FROM schema_version;";
+    db << "INSERT INTO schema_version VALUES (?);" << current_schema_version;
+
     db <<
 "CREATE TABLE IF NOT EXISTS samplers\n\
     (id                 INTEGER NOT NULL PRIMARY KEY\n\
@@ -37,7 +335,8 @@ void Database::create_tables()
      max_num_levels     INTEGER,\n\
      lambda             REAL NOT NULL,\n\
      beta               REAL NOT NULL,\n\
-     max_num_saves      INTEGER NOT NULL);";
+     max_num_saves      INTEGER NOT NULL,\n\
+     likelihood_calls   INTEGER NOT NULL DEFAULT 0);";
 
     db <<
 "CREATE TABLE IF NOT EXISTS rngs\n\
@@ -65,15 +364,32 @@ void Database::create_tables()
     exceeds INTEGER NOT NULL DEFAULT 0,\n\
     visits  INTEGER NOT NULL DEFAULT 0,\n\
     accepts INTEGER NOT NULL DEFAULT 0,\n\
-    tries   INTEGER NOT NULL DEFAULT 0);";
+    tries   INTEGER NOT NULL DEFAULT 0,\n\
+    log_scale REAL NOT NULL DEFAULT 0.0,\n\
+    evaluations INTEGER NOT NULL DEFAULT 0,\n\
+    early_exits INTEGER NOT NULL DEFAULT 0);";
+
+    // Seconds each thread spent in each phase since the previous save,
+    // when compiled with DNest5_TIMINGS
+    db <<
+"CREATE TABLE IF NOT EXISTS timings\n\
+    (save           INTEGER NOT NULL,\n\
+     thread         INTEGER NOT NULL,\n\
+     perturb        REAL NOT NULL,\n\
+     log_likelihood REAL NOT NULL,\n\
+     record_stats   REAL NOT NULL,\n\
+     barrier        REAL NOT NULL,\n\
+     level_merge    REAL NOT NULL,\n\
+     saving         REAL NOT NULL,\n\
+     PRIMARY KEY (save, thread));";
 }
 
 void Database::create_indexes()
 {
-    db <<
-"CREATE INDEX IF NOT EXISTS particle_logl_tb_idx\n\
-ON particles (logl, tb);";
-
+    // There are only ever a few hundred levels, and the upsert in the
+    // sampler never changes (logl, tb), so this one is cheap to maintain.
+    // The rowid (level id) is implicitly part of the index, which makes it
+    // covering for levels_leq_particles.
     db <<
 "CREATE INDEX IF NOT EXISTS level_logl_tb_idx\n\
 ON levels (logl, tb);";
@@ -0,0 +1,248 @@
+#include "Dataset.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace DNest5
+{
+
+// Binary header layout
+static constexpr char magic[8] = {'D', 'N', '5', 'D', 'A', 'T', 'A', '1'};
+struct DatasetHeader
+{
+    char magic[8];
+    std::uint64_t num_rows;
+    std::uint64_t num_columns;
+    std::uint64_t stride;
+};
+
+// Parse one line into values. Returns false if any field isn't a number.
+static bool parse_row(const std::string& line, std::vector<double>& values)
+{
+    values.clear();
+    const char* p = line.c_str();
+    while(true)
+    {
+        while(*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')
+            ++p;
+        if(*p == '\0' || *p == '#')
+            return true;
+        char* end;
+        double x = std::strtod(p, &end);
+        if(end == p)
+            return false;
+        values.push_back(x);
+        p = end;
+    }
+}
+
+Dataset::Dataset()
+:map(nullptr)
+,map_size(0)
+,num_rows(0)
+,num_columns(0)
+,stride(0)
+{
+
+}
+
+Dataset::Dataset(const std::string& filename)
+:Dataset()
+{
+    if(is_binary(filename))
+    {
+        open_binary(filename);
+        return;
+    }
+
+    namespace fs = std::filesystem;
+    std::string binary_file = filename + ".bin";
+    std::error_code ec;
+    if(!fs::exists(binary_file) || !is_binary(binary_file) ||
+       fs::last_write_time(binary_file, ec) < fs::last_write_time(filename, ec))
+        convert(filename, binary_file);
+    open_binary(binary_file);
+}
+
+Dataset::Dataset(Dataset&& other)
+:Dataset()
+{
+    *this = std::move(other);
+}
+
+Dataset& Dataset::operator = (Dataset&& other)
+{
+    if(this != &other)
+    {
+        unmap();
+        map = std::exchange(other.map, nullptr);
+        map_size = std::exchange(other.map_size, 0);
+        num_rows = std::exchange(other.num_rows, 0);
+        num_columns = std::exchange(other.num_columns, 0);
+        stride = std::exchange(other.stride, 0);
+    }
+    return *this;
+}
+
+Dataset::~Dataset()
+{
+    unmap();
+}
+
+void Dataset::unmap()
+{
+    if(map != nullptr)
+        munmap(const_cast<char*>(map), map_size);
+    map = nullptr;
+    map_size = 0;
+}
+
+bool Dataset::is_binary(const std::string& filename)
+{
+    std::fstream fin(filename, std::ios::in | std::ios::binary);
+    char start[sizeof(magic)];
+    if(!fin.read(start, sizeof(magic)))
+        return false;
+    return std::memcmp(start, magic, sizeof(magic)) == 0;
+}
+
+void Dataset::convert(const std::string& text_file,
+                      const std::string& binary_file)
+{
+    std::fstream fin(text_file, std::ios::in);
+    if(!fin)
+    {
+        std::cerr << "Couldn't open data file " << text_file << '.';
+        std::cerr << std::endl;
+        exit(-1);
+    }
+
+    // Read row by row, keeping the values in row-major order
+    std::vector<double> values, row;
+    std::size_t rows = 0, cols = 0;
+    std::string line;
+    int line_number = 0;
+    while(std::getline(fin, line))
+    {
+        ++line_number;
+        bool ok = parse_row(line, row);
+        if(!ok && rows == 0)
+            continue;   // A header
+        if(ok && row.size() == 0)
+            continue;   // Blank line or comment
+        if(!ok || (rows > 0 && row.size() != cols))
+        {
+            std::cerr << "Bad row at " << text_file << ':' << line_number;
+            std::cerr << '.' << std::endl;
+            exit(-1);
+        }
+        cols = row.size();
+        values.insert(values.end(), row.begin(), row.end());
+        ++rows;
+    }
+    fin.close();
+
+    // Transpose into aligned columns
+    DatasetHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.num_rows = rows;
+    header.num_columns = cols;
+    header.stride = (rows*sizeof(double) + alignment - 1)/alignment*alignment;
+    std::vector<char> bytes(header_size + cols*header.stride, 0);
+    std::memcpy(&bytes[0], &header, sizeof(header));
+    for(std::size_t j=0; j<cols; ++j)
+    {
+        char* col = &bytes[header_size + j*header.stride];
+        for(std::size_t i=0; i<rows; ++i)
+            std::memcpy(col + i*sizeof(double), &values[i*cols + j],
+                        sizeof(double));
+    }
+
+    // Write to a temporary file and rename it into place
+    std::stringstream ss;
+    ss << binary_file << ".tmp" << getpid();
+    std::string temp_file = ss.str();
+    std::fstream fout(temp_file, std::ios::out | std::ios::binary);
+    fout.write(bytes.data(), bytes.size());
+    fout.close();
+    if(!fout)
+    {
+        std::cerr << "Couldn't write " << temp_file << '.' << std::endl;
+        exit(-1);
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_file, binary_file, ec);
+    if(ec)
+    {
+        std::cerr << "Couldn't rename " << temp_file << " to ";
+        std::cerr << binary_file << ": " << ec.message() << std::endl;
+        exit(-1);
+    }
+}
+
+void Dataset::open_binary(const std::string& filename)
+{
+    unmap();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if(fd < 0 || fstat(fd, &info) != 0)
+    {
+        std::cerr << "Couldn't open " << filename << ": ";
+        std::cerr << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+
+    map_size = info.st_size;
+    void* result = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(result == MAP_FAILED)
+    {
+        std::cerr << "Couldn't map " << filename << ": ";
+        std::cerr << std::strerror(errno) << std::endl;
+        exit(-1);
+    }
+    map = static_cast<const char*>(result);
+
+    DatasetHeader header{};
+    if(map_size >= header_size)
+        std::memcpy(&header, map, sizeof(header));
+    if(map_size < header_size ||
+       std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+       header.stride < header.num_rows*sizeof(double) ||
+       header.stride % alignment != 0 ||
+       map_size < header_size + header.num_columns*header.stride)
+    {
+        std::cerr << filename << " is not a valid dataset." << std::endl;
+        exit(-1);
+    }
+    num_rows = header.num_rows;
+    num_columns = header.num_columns;
+    stride = header.stride;
+}
+
+std::span<const double> Dataset::column(std::size_t j) const
+{
+    if(j >= num_columns)
+    {
+        std::cerr << "Dataset has no column " << j << '.' << std::endl;
+        exit(-1);
+    }
+    auto start = reinterpret_cast<const double*>(map + header_size + j*stride);
+    return std::span<const double>(start, num_rows);
+}
+
+} // namespace
+
@@ -1,4 +1,5 @@
 #include "Levels.h"
+#include "Logger.h"
 
 
 namespace DNest5
@@ -11,6 +12,10 @@ Levels::Levels(const Options& _options)
 ,log_push{0.0}
 ,push_is_active(true)
 ,exceeds{0}, visits{0}, accepts{0}, tries{0}
+,log_scales{0.0}
+,tuned_accepts{0}, tuned_tries{0}
+,scales_frozen(!options.adaptive_proposals)
+,evaluations{0}, early_exits{0}
 {
     // Reserve some RAM
     if(options.max_num_levels.has_value())
@@ -22,6 +27,11 @@ Levels::Levels(const Options& _options)
         visits.reserve(*options.max_num_levels);
         accepts.reserve(*options.max_num_levels);
         tries.reserve(*options.max_num_levels);
+        log_scales.reserve(*options.max_num_levels);
+        tuned_accepts.reserve(*options.max_num_levels);
+        tuned_tries.reserve(*options.max_num_levels);
+        evaluations.reserve(*options.max_num_levels);
+        early_exits.reserve(*options.max_num_levels);
     }
     stash.reserve(int(1.5*options.new_level_interval));
 }
@@ -73,6 +83,13 @@ bool Levels::create_level()
     accepts.push_back(0);
     tries.push_back(0);
     log_push.push_back(0.0);
+
+    // A new level starts from the scale of the one below
+    log_scales.push_back(log_scales.back());
+    tuned_accepts.push_back(0);
+    tuned_tries.push_back(0);
+    evaluations.push_back(0);
+    early_exits.push_back(0);
     stash.clear();
 
     // Recompute log_push
@@ -87,11 +104,15 @@ bool Levels::create_level()
             log_push[i] = 0.0;
     }
 
-    std::cout << "Created level " << logxs.size() << " with logl = ";
-    std::cout << std::get<0>(pairs.back()) << "." << std::endl;
+    auto message = Logger::stream();
+    message << "Created level " << logxs.size() << " with logl = ";
+    message << std::get<0>(pairs.back()) << ".";
+    log_event(LogLevel::info, "level_created", message.str(),
+              {{"level", logxs.size() - 1},
+               {"logl", std::get<0>(pairs.back())}});
 
     if(!push_is_active)
-        std::cout << "Done creating levels." << std::endl;
+        log_event(LogLevel::info, "levels_done", "Done creating levels.");
 
     return true;
 }
@@ -108,6 +129,34 @@ void Levels::revise()
     }
 }
 
+void Levels::tune_scales()
+{
+    if(scales_frozen)
+        return;
+
+    // Robbins-Monro style updates from the acceptance rate since the last
+    // tuning, for levels that have had enough tries for it to mean much
+    static constexpr double target = 0.3;
+    static constexpr unsigned long long min_tries = 200;
+    for(int i=0; i<int(logxs.size()); ++i)
+    {
+        unsigned long long t = tries[i] - tuned_tries[i];
+        if(t < min_tries)
+            continue;
+        double rate = double(accepts[i] - tuned_accepts[i])/t;
+        log_scales[i] += 2.0*(rate - target);
+        log_scales[i] = std::clamp(log_scales[i], log(1E-9), 0.0);
+        tuned_accepts[i] = accepts[i];
+        tuned_tries[i] = tries[i];
+    }
+
+    if(!push_is_active)
+    {
+        scales_frozen = true;
+        log_event(LogLevel::info, "scales_frozen", "Froze proposal scales.");
+    }
+}
+
 void Levels::clear_stash()
 {
     stash.clear();
@@ -119,7 +168,7 @@ void Levels::import_stash_from(const Levels& other)
         stash.push_back(point);
 }
 
-void Levels::adjust(int level, int e, int v, int a, int t)
+void Levels::adjust(int level, int e, int v, int a, int t, int ev, int ee)
 {
     if(level >= int(logxs.size()))
         return;
@@ -127,6 +176,8 @@ void Levels::adjust(int level, int e, int v, int a, int t)
     visits[level] += v;
     accepts[level] += a;
     tries[level] += t;
+    evaluations[level] += ev;
+    early_exits[level] += ee;
 }
 
 double Levels::recent_logl_changes() const
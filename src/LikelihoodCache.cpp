@@ -0,0 +1,92 @@
+#include "LikelihoodCache.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace DNest5
+{
+
+LikelihoodCache::LikelihoodCache(std::size_t _capacity)
+:capacity(_capacity)
+,hits(0)
+,misses(0)
+{
+    index.reserve(capacity);
+}
+
+std::optional<double> LikelihoodCache::find(std::uint64_t key)
+{
+    auto it = index.find(key);
+    if(it == index.end())
+    {
+        ++misses;
+        return std::nullopt;
+    }
+
+    // Move to the front
+    ++hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void LikelihoodCache::insert(std::uint64_t key, double logl)
+{
+    if(capacity == 0)
+        return;
+
+    auto it = index.find(key);
+    if(it != index.end())
+    {
+        it->second->second = logl;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    // Evict the least recently used, reusing its node
+    if(entries.size() == capacity)
+    {
+        index.erase(entries.back().first);
+        entries.splice(entries.begin(), entries, std::prev(entries.end()));
+        entries.front() = {key, logl};
+    }
+    else
+        entries.emplace_front(key, logl);
+    index.emplace(key, entries.begin());
+}
+
+std::string LikelihoodCache::report(std::span<const LikelihoodCache> caches)
+{
+    unsigned long long h = 0, m = 0;
+    for(const auto& cache: caches)
+    {
+        h += cache.hits;
+        m += cache.misses;
+    }
+
+    std::stringstream ss;
+    ss << std::setprecision(4);
+    ss << "Likelihood cache: " << h << " hits, " << m << " misses (";
+    ss << (h + m > 0 ? 100.0*h/(h + m) : 0.0) << "% hit rate).";
+    return ss.str();
+}
+
+std::uint64_t LikelihoodCache::hash(std::span<const double> values)
+{
+    // splitmix64's finaliser applied after mixing in each value
+    std::uint64_t h = 0x9E3779B97F4A7C15ULL ^ values.size();
+    for(double x: values)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        h ^= bits;
+        h = (h ^ (h >> 30))*0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27))*0x94D049BB133111EBULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+} // namespace
+
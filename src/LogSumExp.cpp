@@ -0,0 +1,47 @@
+#include "LogSumExp.h"
+
+#include <algorithm>
+
+namespace DNest5
+{
+
+LogSumExp::LogSumExp()
+:max_logw(Tools::minus_infinity)
+,sum(0.0)
+,sum_f(0.0)
+{
+
+}
+
+void LogSumExp::merge(const LogSumExp& other)
+{
+    if(other.sum == 0.0)
+        return;
+    if(sum == 0.0)
+    {
+        *this = other;
+        return;
+    }
+
+    double new_max = std::max(max_logw, other.max_logw);
+    double scale1 = exp(max_logw - new_max);
+    double scale2 = exp(other.max_logw - new_max);
+    sum   = sum*scale1 + other.sum*scale2;
+    sum_f = sum_f*scale1 + other.sum_f*scale2;
+    max_logw = new_max;
+}
+
+double LogSumExp::get_log_total() const
+{
+    if(sum == 0.0)
+        return Tools::minus_infinity;
+    return max_logw + log(sum);
+}
+
+double LogSumExp::get_mean() const
+{
+    return sum_f/sum;
+}
+
+} // namespace
+
@@ -0,0 +1,202 @@
+#include "Logger.h"
+#include "Options.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace DNest5
+{
+
+Logger::Logger()
+:level(LogLevel::info)
+,json(false)
+,round_interval(0.0)
+,start_time(std::chrono::steady_clock::now())
+,writing(false)
+,stopping(false)
+{
+    writer = std::thread(&Logger::write_loop, this);
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    writer.join();
+}
+
+Logger& Logger::get()
+{
+    static Logger logger;
+    return logger;
+}
+
+void Logger::configure(const std::string& _level, const std::string& format,
+                       double _round_interval)
+{
+    static const std::vector<std::string> names =
+                            {"debug", "info", "warning", "error", "quiet"};
+    auto it = std::find(names.begin(), names.end(), _level);
+    if(it == names.end())
+    {
+        std::cerr << "Unknown log level '" << _level << "'. ";
+        std::cerr << "Use debug, info, warning, error or quiet." << std::endl;
+        exit(-1);
+    }
+    if(format != "text" && format != "json")
+    {
+        std::cerr << "Unknown log format '" << format << "'. ";
+        std::cerr << "Use text or json." << std::endl;
+        exit(-1);
+    }
+
+    // Anything already queued is written the old way
+    flush();
+    level = LogLevel(it - names.begin());
+    json = (format == "json");
+    round_interval = _round_interval;
+    last_round = std::chrono::steady_clock::time_point{};
+}
+
+bool Logger::round_due()
+{
+    if(!enabled(LogLevel::info))
+        return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if(last_round != std::chrono::steady_clock::time_point{} &&
+       std::chrono::duration<double>(now - last_round).count() < round_interval)
+        return false;
+    last_round = now;
+    return true;
+}
+
+void Logger::log(LogLevel _level, std::string event, std::string message,
+                 LogFields fields)
+{
+    if(!enabled(_level))
+        return;
+
+    double seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_time).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({_level, std::move(event), std::move(message),
+                         std::move(fields), seconds});
+    }
+    queued.notify_one();
+}
+
+void Logger::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this]() { return queue.empty() && !writing; });
+}
+
+std::stringstream Logger::stream()
+{
+    std::stringstream ss;
+    ss << std::setprecision(Options::stdout_precision);
+    return ss;
+}
+
+void Logger::write_loop()
+{
+    std::vector<LogRecord> batch;
+    std::string buffer;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        queued.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if(queue.empty())
+            return;
+
+        // Render and write outside the lock, so log() never waits on stdout
+        batch.swap(queue);
+        writing = true;
+        lock.unlock();
+
+        buffer.clear();
+        for(const auto& record: batch)
+            buffer += render(record, json);
+        std::cout << buffer << std::flush;
+        batch.clear();
+
+        lock.lock();
+        writing = false;
+        written.notify_all();
+    }
+}
+
+// Append s as a JSON string
+static void append_json(std::string& out, const std::string& s)
+{
+    out += '"';
+    for(char c: s)
+    {
+        switch(c)
+        {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if((unsigned char)c < 0x20)
+                {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                }
+                else
+                    out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string Logger::render(const LogRecord& record, bool as_json)
+{
+    if(!as_json)
+        return record.message + '\n';
+
+    static const char* names[] = {"debug", "info", "warning", "error"};
+    std::stringstream ss;
+    ss << std::setprecision(Options::stdout_precision);
+    ss << "{\"time\": " << record.seconds << ", \"level\": \"";
+    ss << names[int(record.level)] << "\", \"event\": ";
+    std::string out = ss.str();
+    append_json(out, record.event);
+    out += ", \"message\": ";
+    append_json(out, record.message);
+
+    for(const auto& [name, value]: record.fields)
+    {
+        out += ", ";
+        append_json(out, name);
+        out += ": ";
+        if(auto s = std::get_if<std::string>(&value))
+            append_json(out, *s);
+        else if(auto b = std::get_if<bool>(&value))
+            out += (*b)?("true"):("false");
+        else
+        {
+            std::stringstream v;
+            v << std::setprecision(Options::stdout_precision);
+            std::visit([&v](const auto& x) { v << x; }, value);
+            auto d = std::get_if<double>(&value);
+            out += (d && !std::isfinite(*d))?("null"):(v.str());
+        }
+    }
+    out += "}\n";
+    return out;
+}
+
+} // namespace
+
@@ -1,7 +1,8 @@
 #include "Misc.h"
+#include "Logger.h"
 
+#include <cmath>
 #include <cstdio>
-#include <iostream>
 #include <string>
 #include <vector>
 
@@ -14,9 +15,9 @@ void clear_output_dir()
         "dnest5.db", "dnest5.db-shm", "dnest5.db-wal",
         "figure1.pdf", "figure2.pdf", "figure3.pdf",
         "posterior.csv", "posterior.db", "posterior.db-shm", "posterior.db-wal",
-        "results.yaml"};
+        "results.yaml", "status.json"};
 
-    std::cout << "Clearing output directory." << std::endl;
+    log_event(LogLevel::info, "clear_output_dir", "Clearing output directory.");
     for(const auto& file: files)
     {
         std::string path = "output/" + file;
@@ -24,5 +25,35 @@ void clear_output_dir()
     }
 }
 
+double rand_gamma(Tools::RNG& rng, double shape)
+{
+    // Marsaglia and Tsang (2000), with the usual boost for shape < 1
+    if(shape < 1.0)
+        return rand_gamma(rng, shape + 1.0)*pow(rng.rand(), 1.0/shape);
+
+    double d = shape - 1.0/3.0;
+    double c = 1.0/sqrt(9.0*d);
+    while(true)
+    {
+        double x, v;
+        do
+        {
+            x = rng.randn();
+            v = 1.0 + c*x;
+        }while(v <= 0.0);
+        v = v*v*v;
+        double u = rng.rand();
+        if(log(u) < 0.5*x*x + d - d*v + d*log(v))
+            return d*v;
+    }
+}
+
+double rand_beta(Tools::RNG& rng, double a, double b)
+{
+    double x = rand_gamma(rng, a);
+    double y = rand_gamma(rng, b);
+    return x/(x + y);
+}
+
 } // namespace
 
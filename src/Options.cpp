@@ -1,4 +1,5 @@
 #include "Options.h"
+#include "Logger.h"
 
 namespace DNest5
 {
@@ -14,7 +15,19 @@ Options::Options(int _num_particles,
                  double _lambda,
                  double _beta,
                  int _max_num_saves,
-                 std::optional<int> _rng_seed)
+                 std::optional<int> _rng_seed,
+                 std::string _compression,
+                 std::optional<double> _snapshot_interval,
+                 double _max_data_loss,
+                 bool _adaptive_proposals,
+                 int _batch_size,
+                 int _likelihood_cache_size,
+                 int _num_tries,
+                 std::optional<int> _helper_threads,
+                 std::optional<double> _status_interval,
+                 std::string _log_level,
+                 std::string _log_format,
+                 double _log_interval)
 :num_particles(_num_particles)
 ,num_threads(_num_threads)
 ,new_level_interval(_new_level_interval)
@@ -25,11 +38,37 @@ Options::Options(int _num_particles,
 ,beta(_beta)
 ,max_num_saves(_max_num_saves)
 ,rng_seed(_rng_seed.value_or(time(0)))
+,compression(std::move(_compression))
+,snapshot_interval(_snapshot_interval)
+,max_data_loss(_max_data_loss)
+,adaptive_proposals(_adaptive_proposals)
+,batch_size(_batch_size)
+,likelihood_cache_size(_likelihood_cache_size)
+,num_tries(_num_tries)
+,helper_threads(_helper_threads)
+,status_interval(_status_interval)
+,log_level(std::move(_log_level))
+,log_format(std::move(_log_format))
+,log_interval(_log_interval)
 {
-    std::cout << std::setprecision(stdout_precision);
     assert(save_interval % num_threads == 0);
     assert(num_particles % num_threads == 0);
     assert(max_num_saves % num_threads == 0);
+    assert(!snapshot_interval || *snapshot_interval > 0.0);
+    assert(max_data_loss >= snapshot_interval.value_or(0.0));
+    assert(batch_size >= 1);
+    assert(likelihood_cache_size >= 0);
+    assert(num_tries >= 1);
+    assert(!helper_threads || *helper_threads >= 0);
+    assert((!helper_threads || *helper_threads != 1) &&
+           "helper_threads: 1 is no help, as the pool counts its caller. \
+Use 0 or at least 2.");
+    assert(!status_interval || *status_interval >= 0.0);
+    assert(log_interval >= 0.0);
+
+    // Like the precision, this is for the whole process
+    Logger::get().configure(log_level, log_format, log_interval);
+    std::cout << std::setprecision(stdout_precision);
 }
 
 Options::Options(const char* yaml_file)
@@ -64,9 +103,108 @@ Options::Options(const char* yaml_file)
         rng_seed = time(0);
     }
 
+    // Optional, for older files
+    compression = "none";
+    if(file["compression"])
+        compression = file["compression"].as<std::string>();
+
+    // Optional. A number of seconds means run the database in memory and
+    // copy it to disk that often.
+    snapshot_interval = std::optional<double>();
+    if(file["snapshot_interval"])
+    {
+        try
+        {
+            snapshot_interval = file["snapshot_interval"].as<double>();
+        }
+        catch(const YAML::TypedBadConversion<double>& e)
+        {
+
+        }
+    }
+    max_data_loss = 60.0;
+    if(file["max_data_loss"])
+        max_data_loss = file["max_data_loss"].as<double>();
+
+    // Optional. Tune proposal scales for each level while levels are built.
+    adaptive_proposals = false;
+    if(file["adaptive_proposals"])
+        adaptive_proposals = file["adaptive_proposals"].as<bool>();
+
+    // Optional. How many of a thread's particles to step at once.
+    batch_size = 1;
+    if(file["batch_size"])
+        batch_size = file["batch_size"].as<int>();
+
+    // Optional. Log likelihoods each thread remembers, for models with hash().
+    likelihood_cache_size = 0;
+    if(file["likelihood_cache_size"])
+        likelihood_cache_size = file["likelihood_cache_size"].as<int>();
+
+    // Optional. Proposals per step, evaluated on that many extra threads.
+    num_tries = 1;
+    if(file["num_tries"])
+        num_tries = file["num_tries"].as<int>();
+
+    // Optional. Threads shared by likelihood evaluations. "auto" means one
+    // per core not running a sampler thread. 1 is not allowed, because the
+    // calling thread counts as one of the pool's, so it would add nothing.
+    helper_threads = std::optional<int>();
+    if(file["helper_threads"])
+    {
+        try
+        {
+            helper_threads = file["helper_threads"].as<int>();
+        }
+        catch(const YAML::TypedBadConversion<int>& e)
+        {
+            helper_threads = std::optional<int>();
+        }
+    }
+
+    // Optional. Seconds between updates of output/status.json, or "none".
+    status_interval = 1.0;
+    if(file["status_interval"])
+    {
+        try
+        {
+            status_interval = file["status_interval"].as<double>();
+        }
+        catch(const YAML::TypedBadConversion<double>& e)
+        {
+            status_interval = std::optional<double>();
+        }
+    }
+
+    // Optional. Which messages to print and how, and the least number of
+    // seconds between progress messages.
+    log_level = "info";
+    if(file["log_level"])
+        log_level = file["log_level"].as<std::string>();
+    log_format = "text";
+    if(file["log_format"])
+        log_format = file["log_format"].as<std::string>();
+    log_interval = 0.0;
+    if(file["log_interval"])
+        log_interval = file["log_interval"].as<double>();
+
     assert(save_interval % num_threads == 0);
     assert(num_particles % num_threads == 0);
     assert(max_num_saves % num_threads == 0);
+    assert(!snapshot_interval || *snapshot_interval > 0.0);
+    assert(max_data_loss >= snapshot_interval.value_or(0.0));
+    assert(batch_size >= 1);
+    assert(likelihood_cache_size >= 0);
+    assert(num_tries >= 1);
+    assert(!helper_threads || *helper_threads >= 0);
+    assert((!helper_threads || *helper_threads != 1) &&
+           "helper_threads: 1 is no help, as the pool counts its caller. \
+Use 0 or at least 2.");
+    assert(!status_interval || *status_interval >= 0.0);
+    assert(log_interval >= 0.0);
+
+    // Like the precision, this is for the whole process
+    Logger::get().configure(log_level, log_format, log_interval);
 }
 
 } // namespace
@@ -0,0 +1,77 @@
+#include "Status.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <unistd.h>
+
+namespace DNest5
+{
+
+Status::Status(std::string _filename, std::optional<double> _interval)
+:filename(std::move(_filename))
+,interval(_interval)
+,last_write(std::chrono::steady_clock::now())
+{
+
+}
+
+bool Status::due() const
+{
+    return interval && seconds_since_write() >= *interval;
+}
+
+double Status::seconds_since_write() const
+{
+    return std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - last_write).count();
+}
+
+void Status::write(const std::string& json)
+{
+    if(!interval)
+        return;
+    last_write = std::chrono::steady_clock::now();
+
+    // A failed write only costs the monitor an update, so don't stop the run
+    std::string temp = filename + ".tmp";
+    {
+        std::fstream fout(temp, std::ios::out);
+        fout << json << std::endl;
+        if(!fout)
+        {
+            std::cerr << "Couldn't write " << temp << "." << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, filename, error);
+    if(error)
+        std::cerr << "Couldn't replace " << filename << "." << std::endl;
+}
+
+std::string Status::number(double x)
+{
+    if(!std::isfinite(x))
+        return "null";
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<double>::max_digits10) << x;
+    return ss.str();
+}
+
+std::uintmax_t Status::resident_memory()
+{
+    // Second field of statm is resident pages, on Linux
+    std::fstream fin("/proc/self/statm", std::ios::in);
+    std::uintmax_t size, resident;
+    if(!(fin >> size >> resident))
+        return 0;
+    return resident*sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
@@ -0,0 +1,80 @@
+#include "ThreadPool.h"
+
+namespace DNest5
+{
+
+ThreadPool::ThreadPool(int num_threads)
+:busy(0)
+,queued(0)
+,stopping(false)
+{
+    if(num_threads <= 1)
+        return;
+
+    workers.reserve(num_threads);
+    for(int i=0; i<num_threads; ++i)
+        workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for(auto& worker: workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    if(workers.size() == 0)
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back(std::move(task));
+        queued.store(tasks.size(), std::memory_order_relaxed);
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    tasks_finished.wait(lock, [this]() { return tasks.empty() && busy == 0; });
+}
+
+void ThreadPool::work()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock,
+                                [this]() { return stopping || !tasks.empty(); });
+            if(stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            queued.store(tasks.size(), std::memory_order_relaxed);
+            ++busy;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy;
+        }
+        tasks_finished.notify_all();
+    }
+}
+
+} // namespace
+
@@ -0,0 +1,36 @@
+#include "Timings.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace DNest5
+{
+
+std::string PhaseTimes::report(std::span<const PhaseTimes> times)
+{
+    std::array<double, num_phases> totals{};
+    double total = 0.0;
+    for(const auto& t: times)
+    {
+        for(int i=0; i<num_phases; ++i)
+        {
+            totals[i] += t.seconds[i];
+            total += t.seconds[i];
+        }
+    }
+
+    std::stringstream ss;
+    ss << "Thread seconds by phase (" << times.size() << " threads):\n";
+    ss << std::fixed;
+    for(int i=0; i<num_phases; ++i)
+    {
+        ss << "    " << std::left << std::setw(16) << phase_names[i];
+        ss << std::right << std::setprecision(3) << std::setw(12) << totals[i];
+        ss << std::setprecision(1) << std::setw(8);
+        ss << ((total > 0.0)?(100.0*totals[i]/total):(0.0)) << "%\n";
+    }
+    return ss.str();
+}
+
+} // namespace
+
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+
+import json
+import sys
+import time
+
+def summary(status):
+    """ A few lines about a run, from the contents of output/status.json. """
+
+    lines = []
+    done = "finished" if status["finished"] else "running"
+    lines.append("Sampler {id} ({done}, {t:.0f} s)"
+                    .format(id=status["sampler_id"], done=done,
+                            t=status["elapsed_seconds"]))
+    lines.append("Saved particles:    {s} of {m} ({f} full)"
+                    .format(s=status["saved_particles"],
+                            m=status["max_num_saves"],
+                            f=status["saved_full_particles"]))
+    lines.append("Steps per second:   {x:.4g}"
+                    .format(x=status["steps_per_second"] or 0.0))
+    lines.append("Likelihood calls:   {x}".format(x=status["likelihood_calls"]))
+    lines.append("Barrier wait:       {x:.1%}"
+                    .format(x=status["barrier_wait_fraction"] or 0.0))
+    lines.append("Pool queue depth:   {x}".format(x=status["pool_queue_depth"]))
+    lines.append("Level stash:        {s} of {n}"
+                    .format(s=status["stash_size"],
+                            n=status["new_level_interval"]))
+    lines.append("Resident memory:    {x:.1f} MB"
+                    .format(x=status["resident_memory_bytes"]/1048576.0))
+    if "wal_bytes" in status:
+        lines.append("WAL:                {x:.1f} MB"
+                        .format(x=status["wal_bytes"]/1048576.0))
+    else:
+        lines.append("Snapshot age:       {x:.0f} s"
+                        .format(x=status["snapshot_age_seconds"]))
+
+    building = "building" if status["push_is_active"] else "done building"
+    lines.append("Levels:             {n} ({b})"
+                    .format(n=len(status["levels"]), b=building))
+    lines.append("    {:>5} {:>12} {:>16} {:>10}"
+                    .format("level", "log(X)", "log(L)", "accepts"))
+    for i, level in enumerate(status["levels"]):
+        logl = level["logl"]
+        rate = level["acceptance_rate"]
+        lines.append("    {:>5} {:>12.4f} {:>16} {:>10}"
+                        .format(i, level["logx"],
+                                "-inf" if logl is None else "{:.6g}".format(logl),
+                                "-" if rate is None else "{:.1%}".format(rate)))
+    return "\n".join(lines)
+
+
+def read_status(filename):
+    # The sampler replaces the file in one go, so it's always complete
+    with open(filename) as f:
+        return json.load(f)
+
+
+if __name__ == "__main__":
+    # Usage: python status.py [seconds]
+    # With a number of seconds, keep printing until the run finishes
+    filename = "output/status.json"
+    interval = float(sys.argv[1]) if len(sys.argv) >= 2 else None
+
+    while True:
+        status = read_status(filename)
+        if interval is not None:
+            print("\033[2J\033[H", end="")
+        print(summary(status), flush=True)
+        if interval is None or status["finished"]:
+            break
+        time.sleep(interval)